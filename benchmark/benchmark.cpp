@@ -0,0 +1,421 @@
+#include <opencv2/opencv.hpp>
+#include <json/json.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pool_buffers.hpp"
+#include "realce.hpp"
+#include "movimiento.hpp"
+#include "ruido.hpp"
+#include "suavizado.hpp"
+#include "bordes.hpp"
+#include "morfologia.hpp"
+#include "pixel.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Frames de la secuencia sintética: el detector de movimiento los recorre en ciclo
+const int framesSecuencia = 8;
+
+// Función que genera el frame `indice` de una secuencia sintética determinista: un
+// degradado con textura pseudoaleatoria (el mismo hash del ruido de parte2) y dos
+// figuras que se desplazan con el índice, para que haya bordes y movimiento
+void generarFrame(Size tamano, int indice, Mat& frame) {
+    frame.create(tamano, CV_8UC3);
+    parallel_for_(Range(0, tamano.height), [&](const Range& rango) {
+        for (int y = rango.start; y < rango.end; y++) {
+            Vec3b* fila = frame.ptr<Vec3b>(y);
+            for (int x = 0; x < tamano.width; x++) {
+                uint32_t ruido = mezclar32(uint32_t(y) * uint32_t(tamano.width) + uint32_t(x)) & 31;
+                fila[x] = Vec3b(uchar((x * 255 / tamano.width + ruido) & 255), uchar((y * 255 / tamano.height + ruido) & 255),
+                                uchar((128 + ruido) & 255));
+            }
+        }
+    });
+    int paso = max(1, tamano.width / 64);
+    circle(frame, Point(tamano.width / 4 + indice * paso, tamano.height / 2), tamano.height / 6, Scalar(240, 240, 240), FILLED);
+    rectangle(frame, Rect(tamano.width / 2, tamano.height / 4 + indice * paso, tamano.width / 5, tamano.height / 4),
+              Scalar(20, 20, 20), FILLED);
+}
+
+// Entradas sintéticas de una resolución, preparadas una vez para todas las funciones
+struct Entradas {
+    vector<Mat> color, gris;
+};
+
+Entradas prepararEntradas(Size tamano) {
+    Entradas entradas;
+    entradas.color.resize(framesSecuencia);
+    entradas.gris.resize(framesSecuencia);
+    for (int i = 0; i < framesSecuencia; i++) {
+        generarFrame(tamano, i, entradas.color[i]);
+        cvtColor(entradas.color[i], entradas.gris[i], COLOR_BGR2GRAY);
+    }
+    return entradas;
+}
+
+// Caso de medición: prepara su estado para unas entradas y devuelve la operación a
+// cronometrar, que recibe el número de iteración. Los casos de cadenas por píxel
+// calculan además los bytes que mueven por píxel para reportar el ancho de banda.
+struct Caso {
+    string funcion;
+    function<function<void(int)>(const Entradas&)> preparar;
+    function<int(const Entradas&)> bytesPorPixel;
+};
+
+// Gradientes Sobel de cada frame gris, entrada de las cadenas de magnitud
+shared_ptr<vector<array<Mat, 2>>> prepararGradientes(const Entradas& e) {
+    auto gradientes = make_shared<vector<array<Mat, 2>>>(framesSecuencia);
+    for (int i = 0; i < framesSecuencia; i++) {
+        Sobel(e.gris[i], (*gradientes)[i][0], CV_16S, 1, 0);
+        Sobel(e.gris[i], (*gradientes)[i][1], CV_16S, 0, 1);
+    }
+    return gradientes;
+}
+
+// Apertura y cierre de cada frame gris, entrada del realce morfológico
+shared_ptr<vector<array<Mat, 2>>> prepararAperturaCierre(const Entradas& e) {
+    auto aperturaCierre = make_shared<vector<array<Mat, 2>>>(framesSecuencia);
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(15, 15));
+    for (int i = 0; i < framesSecuencia; i++) {
+        morphologyEx(e.gris[i], (*aperturaCierre)[i][0], MORPH_OPEN, kernel);
+        morphologyEx(e.gris[i], (*aperturaCierre)[i][1], MORPH_CLOSE, kernel);
+    }
+    return aperturaCierre;
+}
+
+// Bytes por píxel de un paso de OpenCV: lee un píxel de cada entrada y escribe uno de la
+// salida, con los tipos de las imágenes del paso (entradas y salida, en cualquier orden)
+int bytesPaso(initializer_list<int> tipos) {
+    int bytes = 0;
+    for (int tipo : tipos) bytes += int(CV_ELEM_SIZE(tipo));
+    return bytes;
+}
+
+// Cadenas por píxel fusionadas con pixel.hpp frente a las mismas cadenas con una
+// llamada de OpenCV por paso: cada paso intermedio escribe una imagen completa y el
+// siguiente la vuelve a leer, así que la versión fusionada mueve menos bytes por píxel.
+// Los bytes de las fusionadas salen de las propias expresiones (pixel::bytesPorElemento);
+// los de OpenCV, de los tipos de cada paso.
+void agregarCasosCadenas(vector<Caso>& casos) {
+    casos.push_back({"cadena_lumaCroma_fusionada", [](const Entradas& e) {
+        auto frame = make_shared<FrameLuma>();
+        auto pool = make_shared<PoolBuffers>();
+        return function<void(int)>([&e, frame, pool](int i) { extraerLuma(e.color[i % framesSecuencia], *frame, *pool); });
+    }, [](const Entradas& e) {
+        Mat y, cr, cb;
+        return pixel::bytesPorElemento(asignacionesLumaCroma(e.color[0], y, cr, cb));
+    }});
+    casos.push_back({"cadena_lumaCroma_opencv", [](const Entradas& e) {
+        auto ycrcb = make_shared<Mat>();
+        auto planos = make_shared<array<Mat, 3>>();
+        return function<void(int)>([&e, ycrcb, planos](int i) {
+            cvtColor(e.color[i % framesSecuencia], *ycrcb, COLOR_BGR2YCrCb);
+            split(*ycrcb, planos->data());
+        });
+    }, [](const Entradas&) { return bytesPaso({CV_8UC3, CV_8UC3}) + bytesPaso({CV_8UC3, CV_8UC1, CV_8UC1, CV_8UC1}); }});
+    casos.push_back({"cadena_diferenciaUmbral_fusionada", [](const Entradas& e) {
+        auto movimiento = make_shared<Mat>();
+        return function<void(int)>([&e, movimiento](int i) {
+            pixel::evaluar(expresionDiferenciaUmbral(e.gris[i % framesSecuencia], e.gris[(i + 1) % framesSecuencia], 10), *movimiento);
+        });
+    }, [](const Entradas& e) {
+        Mat movimiento;
+        return pixel::bytesPorElemento(pixel::asignar(movimiento, expresionDiferenciaUmbral(e.gris[0], e.gris[1], 10)));
+    }});
+    casos.push_back({"cadena_diferenciaUmbral_opencv", [](const Entradas& e) {
+        auto movimiento = make_shared<Mat>();
+        return function<void(int)>([&e, movimiento](int i) {
+            absdiff(e.gris[i % framesSecuencia], e.gris[(i + 1) % framesSecuencia], *movimiento);
+            threshold(*movimiento, *movimiento, 10, 255, THRESH_BINARY);
+        });
+    }, [](const Entradas&) { return bytesPaso({CV_8UC1, CV_8UC1, CV_8UC1}) + bytesPaso({CV_8UC1, CV_8UC1}); }});
+    casos.push_back({"cadena_magnitudSobel_fusionada", [](const Entradas& e) {
+        auto gradientes = prepararGradientes(e);
+        auto magnitud = make_shared<Mat>();
+        return function<void(int)>([gradientes, magnitud](int i) {
+            const array<Mat, 2>& g = (*gradientes)[i % framesSecuencia];
+            magnitudSobel(g[0], g[1], *magnitud);
+        });
+    }, [](const Entradas& e) {
+        Mat grad_x(e.gris[0].size(), CV_16SC1), grad_y(e.gris[0].size(), CV_16SC1), magnitud;
+        return pixel::bytesPorElemento(pixel::asignar(magnitud, expresionMagnitudSobel(grad_x, grad_y)));
+    }});
+    casos.push_back({"cadena_magnitudSobel_opencv", [](const Entradas& e) {
+        auto gradientes = prepararGradientes(e);
+        auto intermedias = make_shared<array<Mat, 3>>();
+        return function<void(int)>([gradientes, intermedias](int i) {
+            const array<Mat, 2>& g = (*gradientes)[i % framesSecuencia];
+            array<Mat, 3>& m = *intermedias;
+            convertScaleAbs(g[0], m[0]);
+            convertScaleAbs(g[1], m[1]);
+            addWeighted(m[0], 0.5, m[1], 0.5, 0, m[2]);
+        });
+    }, [](const Entradas&) { return 2 * bytesPaso({CV_16SC1, CV_8UC1}) + bytesPaso({CV_8UC1, CV_8UC1, CV_8UC1}); }});
+    casos.push_back({"cadena_realceMorfologico_fusionada", [](const Entradas& e) {
+        auto aperturaCierre = prepararAperturaCierre(e);
+        auto salidas = make_shared<array<Mat, 3>>();
+        return function<void(int)>([&e, aperturaCierre, salidas](int i) {
+            const array<Mat, 2>& ac = (*aperturaCierre)[i % framesSecuencia];
+            array<Mat, 3>& s = *salidas;
+            pixel::evaluar(asignacionesRealceMorfologico(e.gris[i % framesSecuencia], ac[0], ac[1], s[0], s[1], s[2]));
+        });
+    }, [](const Entradas& e) {
+        Mat apertura(e.gris[0].size(), CV_8UC1), cierre(e.gris[0].size(), CV_8UC1), s[3];
+        return pixel::bytesPorElemento(asignacionesRealceMorfologico(e.gris[0], apertura, cierre, s[0], s[1], s[2]));
+    }});
+    casos.push_back({"cadena_realceMorfologico_opencv", [](const Entradas& e) {
+        auto aperturaCierre = prepararAperturaCierre(e);
+        auto salidas = make_shared<array<Mat, 4>>();
+        return function<void(int)>([&e, aperturaCierre, salidas](int i) {
+            const Mat& imagen = e.gris[i % framesSecuencia];
+            const array<Mat, 2>& ac = (*aperturaCierre)[i % framesSecuencia];
+            array<Mat, 4>& s = *salidas;
+            subtract(imagen, ac[0], s[0]);
+            subtract(ac[1], imagen, s[1]);
+            subtract(s[0], s[1], s[2]);
+            add(imagen, s[2], s[3]);
+        });
+    }, [](const Entradas&) { return 4 * bytesPaso({CV_8UC1, CV_8UC1, CV_8UC1}); }});
+}
+
+// Todas las funciones de procesamiento de las tres partes
+vector<Caso> crearCasos() {
+    vector<Caso> casos;
+    casos.push_back({"aplicarEcualizacionHistograma", [](const Entradas& e) {
+        auto resultado = make_shared<Mat>();
+        return function<void(int)>([&e, resultado](int i) { aplicarEcualizacionHistograma(e.gris[i % framesSecuencia], *resultado); });
+    }});
+    casos.push_back({"aplicarCLAHE", [](const Entradas& e) {
+        auto resultado = make_shared<Mat>();
+        Ptr<CLAHE> clahe = createCLAHE();
+        clahe->setClipLimit(4);
+        return function<void(int)>([&e, resultado, clahe](int i) { aplicarCLAHE(*clahe, e.gris[i % framesSecuencia], *resultado); });
+    }});
+    casos.push_back({"aplicarCorreccionGamma", [](const Entradas& e) {
+        auto resultado = make_shared<Mat>();
+        auto tabla = make_shared<Mat>();
+        calcularTablaGamma(1.8, *tabla);
+        return function<void(int)>([&e, resultado, tabla](int i) { aplicarCorreccionGamma(e.color[i % framesSecuencia], *tabla, *resultado); });
+    }});
+    for (string backend : {"mog2", "diferencia", "promedio", "mediana"}) {
+        casos.push_back({"detectarMovimiento_" + backend, [backend](const Entradas& e) {
+            shared_ptr<DetectorMovimiento> detector = crearDetectorMovimiento(backend);
+            auto movimiento = make_shared<Mat>();
+            return function<void(int)>([&e, detector, movimiento](int i) { detector->detectar(e.gris[i % framesSecuencia], *movimiento); });
+        }});
+    }
+    // Detección sobre la pirámide de luma de parte1: incluye construir los niveles del frame
+    for (int nivel = 1; nivel <= nivelMaximoPiramide; nivel++) {
+        casos.push_back({"detectarMovimiento_mog2_nivel" + to_string(nivel), [nivel](const Entradas& e) {
+            shared_ptr<DetectorMovimiento> detector = crearDetectorMovimiento("mog2");
+            auto movimiento = make_shared<Mat>();
+            auto pool = make_shared<PoolBuffers>();
+            return function<void(int)>([&e, nivel, detector, movimiento, pool](int i) {
+                FrameLuma frame;
+                frame.y = e.gris[i % framesSecuencia];
+                construirPiramide(frame, nivel, *pool);
+                detector->detectar(frame.luma(nivel), *movimiento);
+            });
+        }});
+    }
+    casos.push_back({"agregarRuidoSalPimienta", [](const Entradas& e) {
+        auto imagen = make_shared<Mat>(e.color[0].clone());
+        return function<void(int)>([imagen](int i) { agregarRuidoSalPimienta(*imagen, 0.05f, 0.05f, uint32_t(i)); });
+    }});
+    for (int mascara : {3, 11, 21}) {
+        casos.push_back({"aplicarFiltros_k" + to_string(mascara), [mascara](const Entradas& e) {
+            auto salidas = make_shared<array<Mat, 3>>();
+            return function<void(int)>([&e, mascara, salidas](int i) {
+                aplicarFiltrosSuavizado(e.color[i % framesSecuencia], mascara, (*salidas)[0], (*salidas)[1], (*salidas)[2]);
+            });
+        }});
+    }
+    // Canny y Sobel comparten la conversión a gris y los gradientes: se miden juntos
+    casos.push_back({"deteccionBordesCannySobel", [](const Entradas& e) {
+        auto salidas = make_shared<array<Mat, 2>>();
+        auto pool = make_shared<PoolBuffers>();
+        return function<void(int)>([&e, salidas, pool](int i) {
+            deteccionBordesCannySobel(e.color[i % framesSecuencia], (*salidas)[0], (*salidas)[1], *pool);
+        });
+    }});
+    for (int kernel : {15, 25, 37}) {
+        casos.push_back({"aplicarOperacionesMorfologicas_k" + to_string(kernel), [kernel](const Entradas& e) {
+            auto motor = make_shared<MotorMorfologico>(kernel);
+            auto salidas = make_shared<array<Mat, 5>>();
+            return function<void(int)>([&e, motor, salidas](int i) {
+                motor->procesar(e.gris[i % framesSecuencia], (*salidas)[0], (*salidas)[1], (*salidas)[2], (*salidas)[3], (*salidas)[4]);
+            });
+        }});
+        casos.push_back({"operacionesMorfologicasOpenCV_k" + to_string(kernel), [kernel](const Entradas& e) {
+            auto salidas = make_shared<array<Mat, 5>>();
+            return function<void(int)>([&e, kernel, salidas](int i) {
+                operacionesMorfologicasOpenCV(e.gris[i % framesSecuencia], kernel, (*salidas)[0], (*salidas)[1], (*salidas)[2],
+                                              (*salidas)[3], (*salidas)[4]);
+            });
+        }});
+    }
+    agregarCasosCadenas(casos);
+    return casos;
+}
+
+// Clave de un resultado para compararlo con la línea base
+string claveResultado(const Json::Value& resultado) {
+    return resultado["funcion"].asString() + " " + resultado["resolucion"].asString() + " hilos=" +
+           to_string(resultado["hilos"].asInt());
+}
+
+// Función que compara los resultados con una línea base y lista las regresiones: casos
+// cuya mediana empeoró más que la tolerancia. Devuelve el número de regresiones.
+int compararConBase(const Json::Value& resultados, const string& rutaBase, double tolerancia) {
+    ifstream archivo(rutaBase);
+    Json::Value base;
+    Json::CharReaderBuilder lector;
+    string errores;
+    if (!archivo || !Json::parseFromStream(lector, archivo, &base, &errores)) {
+        cerr << "No se pudo leer la línea base " << rutaBase << ": " << errores << endl;
+        return -1;
+    }
+    map<string, double> medianasBase;
+    for (const Json::Value& resultado : base["resultados"]) medianasBase[claveResultado(resultado)] = resultado["mediana_ms"].asDouble();
+
+    int regresiones = 0;
+    for (const Json::Value& resultado : resultados) {
+        auto encontrada = medianasBase.find(claveResultado(resultado));
+        if (encontrada == medianasBase.end() || encontrada->second <= 0) continue;
+        double cambio = resultado["mediana_ms"].asDouble() / encontrada->second - 1.0;
+        if (cambio > tolerancia) {
+            cout << "REGRESION " << claveResultado(resultado) << ": " << encontrada->second << " -> "
+                 << resultado["mediana_ms"].asDouble() << " ms (+" << int(cambio * 100) << "%)" << endl;
+            regresiones++;
+        }
+    }
+    cout << regresiones << " regresion(es) frente a " << rutaBase << " (tolerancia " << int(tolerancia * 100) << "%)" << endl;
+    return regresiones;
+}
+
+// Lista separada por comas, como "1,2,8" o "400x240,1920x1080"
+vector<string> separarLista(const string& lista) {
+    vector<string> elementos;
+    stringstream flujo(lista);
+    string elemento;
+    while (getline(flujo, elemento, ',')) {
+        if (!elemento.empty()) elementos.push_back(elemento);
+    }
+    return elementos;
+}
+
+int main(int argc, char** argv) {
+    // Uso: benchmark [--resoluciones=400x240,800x600,1920x1080] [--hilos=1,N] [--repeticiones=N]
+    //                [--filtro=texto] [--salida=benchmark.json] [--comparar=base.json] [--tolerancia=0.15]
+    // Mide cada función sobre frames sintéticos deterministas y escribe la mediana y el mínimo
+    // de cada (función, resolución, hilos) en JSON. Con --comparar marca las regresiones
+    // frente a una ejecución anterior y termina con código 1 si hay alguna.
+    vector<Size> resoluciones = {Size(400, 240), Size(800, 600), Size(1920, 1080)};
+    vector<int> hilos = {1};
+    if (thread::hardware_concurrency() > 1) hilos.push_back(int(thread::hardware_concurrency()));
+    int repeticiones = 20;
+    string filtro, rutaSalida = "benchmark.json", rutaBase;
+    double tolerancia = 0.15;
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento.rfind("--resoluciones=", 0) == 0) {
+            resoluciones.clear();
+            for (const string& texto : separarLista(argumento.substr(15))) {
+                Size tamano;
+                if (sscanf(texto.c_str(), "%dx%d", &tamano.width, &tamano.height) != 2 || tamano.area() <= 0) {
+                    cerr << "Resolución no válida: " << texto << endl;
+                    return -1;
+                }
+                resoluciones.push_back(tamano);
+            }
+        } else if (argumento.rfind("--hilos=", 0) == 0) {
+            hilos.clear();
+            for (const string& texto : separarLista(argumento.substr(8))) hilos.push_back(max(1, atoi(texto.c_str())));
+        } else if (argumento.rfind("--repeticiones=", 0) == 0) {
+            repeticiones = max(1, atoi(argumento.c_str() + 15));
+        } else if (argumento.rfind("--filtro=", 0) == 0) {
+            filtro = argumento.substr(9);
+        } else if (argumento.rfind("--salida=", 0) == 0) {
+            rutaSalida = argumento.substr(9);
+        } else if (argumento.rfind("--comparar=", 0) == 0) {
+            rutaBase = argumento.substr(11);
+        } else if (argumento.rfind("--tolerancia=", 0) == 0) {
+            tolerancia = atof(argumento.c_str() + 13);
+        } else {
+            cerr << "Argumento desconocido: " << argumento << endl;
+            return -1;
+        }
+    }
+
+    vector<Caso> casos = crearCasos();
+    Json::Value resultados(Json::arrayValue);
+    for (Size tamano : resoluciones) {
+        Entradas entradas = prepararEntradas(tamano);
+        string resolucion = to_string(tamano.width) + "x" + to_string(tamano.height);
+        for (int numeroHilos : hilos) {
+            setNumThreads(numeroHilos);
+            for (const Caso& caso : casos) {
+                if (!filtro.empty() && caso.funcion.find(filtro) == string::npos) continue;
+
+                // Estado nuevo por medición; dos iteraciones de calentamiento reservan los buffers
+                function<void(int)> operacion = caso.preparar(entradas);
+                operacion(0);
+                operacion(1);
+                vector<double> tiempos;
+                for (int r = 0; r < repeticiones; r++) {
+                    int64 inicio = getTickCount();
+                    operacion(r + 2);
+                    tiempos.push_back((getTickCount() - inicio) * 1000.0 / getTickFrequency());
+                }
+                sort(tiempos.begin(), tiempos.end());
+
+                Json::Value resultado;
+                resultado["funcion"] = caso.funcion;
+                resultado["resolucion"] = resolucion;
+                resultado["hilos"] = numeroHilos;
+                resultado["repeticiones"] = repeticiones;
+                resultado["mediana_ms"] = tiempos[tiempos.size() / 2];
+                resultado["minimo_ms"] = tiempos.front();
+                cout << caso.funcion << "\t" << resolucion << "\t" << numeroHilos << " hilos\t" << resultado["mediana_ms"].asDouble()
+                     << " ms";
+                if (caso.bytesPorPixel) {
+                    // Tráfico de memoria de la cadena: bytes por píxel y ancho de banda efectivo
+                    int bytesPorPixel = caso.bytesPorPixel(entradas);
+                    double bytes = double(bytesPorPixel) * tamano.area();
+                    resultado["bytes_por_pixel"] = bytesPorPixel;
+                    resultado["gb_por_segundo"] = bytes / (resultado["mediana_ms"].asDouble() * 1e6);
+                    cout << "\t" << bytesPorPixel << " B/px\t" << resultado["gb_por_segundo"].asDouble() << " GB/s";
+                }
+                cout << endl;
+                resultados.append(resultado);
+            }
+        }
+    }
+
+    Json::Value reporte;
+    reporte["opencv"] = CV_VERSION;
+    reporte["resultados"] = resultados;
+    ofstream archivo(rutaSalida);
+    if (!archivo) {
+        cerr << "No se pudo crear " << rutaSalida << endl;
+        return -1;
+    }
+    Json::StreamWriterBuilder escritor;
+    archivo << Json::writeString(escritor, reporte) << endl;
+    cout << "Resultados en " << rutaSalida << endl;
+
+    if (!rutaBase.empty()) return compararConBase(resultados, rutaBase, tolerancia) == 0 ? 0 : 1;
+    return 0;
+}
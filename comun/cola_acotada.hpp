@@ -0,0 +1,96 @@
+#ifndef COLA_ACOTADA_HPP
+#define COLA_ACOTADA_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Cola acotada entre etapas del pipeline. Cuando está llena, insertar descarta
+// el elemento más antiguo: preferimos perder frames viejos a acumular latencia.
+// Con esperarEspacio, insertar espera a que haya lugar y no se pierde nada (para
+// procesar entradas de archivo completas, donde importa más el resultado que la latencia).
+template <typename T>
+class ColaAcotada {
+public:
+    explicit ColaAcotada(size_t capacidad, bool esperarEspacio = false)
+        : capacidad_(capacidad ? capacidad : 1), esperarEspacio_(esperarEspacio) {}
+
+    // Inserta un elemento; devuelve false si la cola ya estaba cerrada
+    bool insertar(T elemento) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (esperarEspacio_) hayEspacio_.wait(lock, [this] { return cerrada_ || elementos_.size() < capacidad_; });
+            if (cerrada_) return false;
+            if (elementos_.size() >= capacidad_) {
+                elementos_.pop_front();
+                ++descartados_;
+            }
+            elementos_.push_back(std::move(elemento));
+        }
+        hayDatos_.notify_one();
+        return true;
+    }
+
+    // Espera hasta que haya un elemento; devuelve false si la cola se cerró y quedó vacía
+    bool extraer(T& elemento) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        hayDatos_.wait(lock, [this] { return cerrada_ || !elementos_.empty(); });
+        if (elementos_.empty()) return false;
+        elemento = std::move(elementos_.front());
+        elementos_.pop_front();
+        hayEspacio_.notify_one();
+        return true;
+    }
+
+    // Extrae el elemento más antiguo sin bloquear; devuelve false si la cola está vacía
+    bool intentarExtraer(T& elemento) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (elementos_.empty()) return false;
+        elemento = std::move(elementos_.front());
+        elementos_.pop_front();
+        hayEspacio_.notify_one();
+        return true;
+    }
+
+    // Extrae el elemento más reciente sin bloquear, descartando los anteriores
+    bool extraerUltimo(T& elemento) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (elementos_.empty()) return false;
+        elemento = std::move(elementos_.back());
+        descartados_ += elementos_.size() - 1;
+        elementos_.clear();
+        hayEspacio_.notify_all();
+        return true;
+    }
+
+    void cerrar() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cerrada_ = true;
+        }
+        hayDatos_.notify_all();
+        hayEspacio_.notify_all();
+    }
+
+    bool cerrada() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cerrada_;
+    }
+
+    size_t descartados() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return descartados_;
+    }
+
+private:
+    size_t capacidad_;
+    bool esperarEspacio_;
+    std::deque<T> elementos_;
+    mutable std::mutex mutex_;
+    std::condition_variable hayDatos_, hayEspacio_;
+    bool cerrada_ = false;
+    size_t descartados_ = 0;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef MOSAICO_HPP
+#define MOSAICO_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <map>
+#include <string>
+#include <tuple>
+#include "pool_buffers.hpp"
+
+// Compositor de mosaicos: columnas x filas paneles del mismo tamaño sobre un lienzo
+// preasignado. Las etapas reciben panel(i), una vista ROI del lienzo, como buffer de
+// salida y escriben ahí directamente, así componer no cuesta copias extra. Las
+// etiquetas se rasterizan una sola vez y luego solo se estampan.
+class Mosaico {
+public:
+    Mosaico(int columnas, int filas, int tipo = CV_8UC3) : columnas_(columnas), filas_(filas), tipo_(tipo) {}
+
+    // Prepara el lienzo para paneles del tamaño dado; reutiliza el buffer si no cambió
+    void preparar(cv::Size tamanoPanel) {
+        tamanoPanel_ = tamanoPanel;
+        lienzo_.create(tamanoPanel.height * filas_, tamanoPanel.width * columnas_, tipo_);
+    }
+
+    // Variante con un lienzo nuevo del pool en cada llamada, para cuando el lienzo
+    // anterior sigue en uso (por ejemplo, esperando en una cola de salida)
+    void preparar(cv::Size tamanoPanel, PoolBuffers& pool) {
+        tamanoPanel_ = tamanoPanel;
+        lienzo_ = pool.obtener(cv::Size(tamanoPanel.width * columnas_, tamanoPanel.height * filas_), tipo_);
+    }
+
+    // Vista del panel i (por filas): escribir en ella escribe en el lienzo
+    cv::Mat panel(int i) const {
+        return lienzo_(cv::Rect((i % columnas_) * tamanoPanel_.width, (i / columnas_) * tamanoPanel_.height,
+                                tamanoPanel_.width, tamanoPanel_.height));
+    }
+
+    // Coloca una imagen en el panel i. Si la etapa ya escribió en la vista del panel
+    // no hace nada; si cambia el número de canales, la conversión escribe en el lienzo.
+    void colocar(int i, const cv::Mat& imagen) {
+        cv::Mat destino = panel(i);
+        if (imagen.data == destino.data) return;
+        if (imagen.channels() == destino.channels()) {
+            imagen.copyTo(destino);
+        } else {
+            cv::cvtColor(imagen, destino, imagen.channels() == 1 ? cv::COLOR_GRAY2BGR : cv::COLOR_BGR2GRAY);
+        }
+    }
+
+    // Estampa una etiqueta blanca en el panel i, con la misma apariencia que putText
+    void etiquetar(int i, const std::string& texto, cv::Point posicion, double escala = 0.7, int grosor = 2) {
+        const Etiqueta& etiqueta = rasterizar(texto, escala, grosor);
+        cv::Mat destino = panel(i);
+        cv::Rect zona(posicion + etiqueta.desplazamiento, etiqueta.mascara.size());
+        cv::Rect visible = zona & cv::Rect(0, 0, destino.cols, destino.rows);
+        if (visible.empty()) return;
+        destino(visible).setTo(cv::Scalar::all(255), etiqueta.mascara(visible - zona.tl()));
+    }
+
+    const cv::Mat& lienzo() const { return lienzo_; }
+
+private:
+    // Máscara de los píxeles del texto y su posición relativa al origen de putText
+    struct Etiqueta {
+        cv::Mat mascara;
+        cv::Point desplazamiento;
+    };
+
+    // Clave de la caché y consulta sobre el texto del llamador: buscar una etiqueta ya
+    // rasterizada no copia el texto ni reserva memoria, solo insertarla
+    struct ClaveEtiqueta {
+        std::string texto;
+        double escala;
+        int grosor;
+    };
+    struct ConsultaEtiqueta {
+        const std::string& texto;
+        double escala;
+        int grosor;
+    };
+    struct OrdenEtiquetas {
+        using is_transparent = void;
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            return std::tie(a.texto, a.escala, a.grosor) < std::tie(b.texto, b.escala, b.grosor);
+        }
+    };
+
+    // Máximo de etiquetas distintas en caché (textos cambiantes como los FPS)
+    static const size_t maximoEtiquetas = 128;
+
+    const Etiqueta& rasterizar(const std::string& texto, double escala, int grosor) {
+        auto encontrada = etiquetas_.find(ConsultaEtiqueta{texto, escala, grosor});
+        if (encontrada != etiquetas_.end()) return encontrada->second;
+        if (etiquetas_.size() >= maximoEtiquetas) etiquetas_.clear();
+
+        // Margen de un grosor completo alrededor de la caja para los trazos gruesos
+        int base = 0;
+        cv::Size caja = cv::getTextSize(texto, cv::FONT_HERSHEY_SIMPLEX, escala, grosor, &base);
+        Etiqueta etiqueta;
+        etiqueta.mascara = cv::Mat::zeros(caja.height + base + 2 * grosor, caja.width + 2 * grosor, CV_8UC1);
+        etiqueta.desplazamiento = cv::Point(-grosor, -caja.height - grosor);
+        cv::putText(etiqueta.mascara, texto, -etiqueta.desplazamiento, cv::FONT_HERSHEY_SIMPLEX, escala, cv::Scalar(255), grosor);
+        return etiquetas_.emplace(ClaveEtiqueta{texto, escala, grosor}, etiqueta).first->second;
+    }
+
+    int columnas_, filas_, tipo_;
+    cv::Size tamanoPanel_;
+    cv::Mat lienzo_;
+    std::map<ClaveEtiqueta, Etiqueta, OrdenEtiquetas> etiquetas_;
+};
+
+#endif
@@ -0,0 +1,286 @@
+#ifndef PIXEL_HPP
+#define PIXEL_HPP
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Operadores por píxel compuestos en tiempo de compilación (plantillas de expresión).
+// Una cadena como umbral(diferenciaAbsoluta(a, b), 10) no calcula nada al escribirse:
+// construye un tipo que describe la cadena, y evaluar() la recorre en un único bucle
+// por filas (repartidas con cv::parallel_for_) sin imágenes intermedias. Tras el
+// inlining, cada píxel es aritmética entera sin saltos que el compilador vectoriza.
+// Los valores intermedios son int; al escribir se saturan a uchar como saturate_cast.
+namespace pixel {
+
+// Base de todas las expresiones (CRTP). Cada expresión E define:
+//  - fila(y): un evaluador de la fila y, invocable con la posición x
+//  - tamano(): elementos por fila y filas (nulo si no lee ninguna imagen)
+//  - lecturas(registrar): llama a registrar(datos, bytes) por cada imagen que lee, con
+//    los bytes que trae de memoria por elemento evaluado
+template <typename E>
+struct Expresion {
+    const E& derivada() const { return static_cast<const E&>(*this); }
+};
+
+template <typename T>
+struct EsExpresion : std::is_base_of<Expresion<T>, T> {};
+
+// Lectura de un Mat de tipo T con todos los elementos de cada fila (los canales quedan
+// intercalados). El paso es 1 en tiempo de compilación: el bucle lee memoria contigua.
+template <typename T>
+struct Lectura : Expresion<Lectura<T>> {
+    explicit Lectura(const cv::Mat& imagen) : imagen_(imagen) {
+        CV_Assert(imagen.depth() == cv::DataType<T>::depth);
+    }
+
+    auto fila(int y) const {
+        const T* p = imagen_.ptr<T>(y);
+        return [p](int x) { return int(p[x]); };
+    }
+
+    cv::Size tamano() const { return cv::Size(imagen_.cols * imagen_.channels(), imagen_.rows); }
+    template <typename F>
+    void lecturas(F& registrar) const { registrar(imagen_.data, int(sizeof(T))); }
+
+private:
+    cv::Mat imagen_;
+};
+
+// Lectura de un solo canal de un Mat de tipo T con `Canales` canales; el paso entre
+// píxeles también es una constante de compilación
+template <typename T, int Canales>
+struct LecturaCanal : Expresion<LecturaCanal<T, Canales>> {
+    LecturaCanal(const cv::Mat& imagen, int canal) : imagen_(imagen), canal_(canal) {
+        CV_Assert(imagen.depth() == cv::DataType<T>::depth && imagen.channels() == Canales && canal >= 0 && canal < Canales);
+    }
+
+    auto fila(int y) const {
+        const T* p = imagen_.ptr<T>(y) + canal_;
+        return [p](int x) { return int(p[x * Canales]); };
+    }
+
+    cv::Size tamano() const { return imagen_.size(); }
+    // Leer un canal trae de memoria el píxel completo
+    template <typename F>
+    void lecturas(F& registrar) const { registrar(imagen_.data, int(sizeof(T)) * Canales); }
+
+private:
+    cv::Mat imagen_;
+    int canal_;
+};
+
+template <typename T>
+Lectura<T> leer(const cv::Mat& imagen) { return Lectura<T>(imagen); }
+
+template <typename T, int Canales>
+LecturaCanal<T, Canales> leerCanal(const cv::Mat& imagen, int canal) { return LecturaCanal<T, Canales>(imagen, canal); }
+
+// Constante entera; los operadores convierten los int en constantes automáticamente
+struct Constante : Expresion<Constante> {
+    explicit Constante(int valor) : valor_(valor) {}
+    auto fila(int) const {
+        const int valor = valor_;
+        return [valor](int) { return valor; };
+    }
+    cv::Size tamano() const { return cv::Size(); }
+    template <typename F>
+    void lecturas(F&) const {}
+
+private:
+    int valor_;
+};
+
+template <typename A>
+const A& comoExpresion(const Expresion<A>& a) { return a.derivada(); }
+inline Constante comoExpresion(int valor) { return Constante(valor); }
+
+// Operación elemento a elemento sobre una expresión
+template <typename A, typename Op>
+struct Unaria : Expresion<Unaria<A, Op>> {
+    Unaria(const A& a, Op op) : a_(a), op_(op) {}
+    auto fila(int y) const {
+        auto a = a_.fila(y);
+        const Op op = op_;
+        return [a, op](int x) { return op(a(x)); };
+    }
+    cv::Size tamano() const { return a_.tamano(); }
+    template <typename F>
+    void lecturas(F& registrar) const { a_.lecturas(registrar); }
+
+private:
+    A a_;
+    Op op_;
+};
+
+// Operación elemento a elemento entre dos expresiones del mismo tamaño (una constante
+// no tiene tamaño y se combina con cualquiera)
+template <typename A, typename B, typename Op>
+struct Binaria : Expresion<Binaria<A, B, Op>> {
+    Binaria(const A& a, const B& b) : a_(a), b_(b) {
+        CV_Assert(a_.tamano().empty() || b_.tamano().empty() || a_.tamano() == b_.tamano());
+    }
+    auto fila(int y) const {
+        auto a = a_.fila(y);
+        auto b = b_.fila(y);
+        return [a, b](int x) { return Op()(a(x), b(x)); };
+    }
+    cv::Size tamano() const { return a_.tamano().empty() ? b_.tamano() : a_.tamano(); }
+    template <typename F>
+    void lecturas(F& registrar) const {
+        a_.lecturas(registrar);
+        b_.lecturas(registrar);
+    }
+
+private:
+    A a_;
+    B b_;
+};
+
+struct Suma { int operator()(int a, int b) const { return a + b; } };
+struct Resta { int operator()(int a, int b) const { return a - b; } };
+struct Producto { int operator()(int a, int b) const { return a * b; } };
+struct YBit { int operator()(int a, int b) const { return a & b; } };
+struct Desplazamiento { int operator()(int a, int b) const { return a >> b; } };
+struct Maximo { int operator()(int a, int b) const { return std::max(a, b); } };
+struct DiferenciaAbsoluta { int operator()(int a, int b) const { return std::abs(a - b); } };
+
+struct Absoluto { int operator()(int a) const { return std::abs(a); } };
+struct Saturar { int operator()(int a) const { return std::min(std::max(a, 0), 255); } };
+struct UmbralBinario {
+    int umbral;
+    int operator()(int a) const { return a > umbral ? 255 : 0; }
+};
+
+template <typename Op, typename A, typename B>
+auto binaria(const A& a, const B& b) {
+    return Binaria<A, B, Op>(a, b);
+}
+
+// Operadores aritméticos: al menos un operando debe ser una expresión
+#define PIXEL_OPERADOR(simbolo, Op)                                                                     \
+    template <typename A, typename B, typename = std::enable_if_t<EsExpresion<A>::value || EsExpresion<B>::value>> \
+    auto operator simbolo(const A& a, const B& b) {                                                     \
+        return binaria<Op>(comoExpresion(a), comoExpresion(b));                                         \
+    }
+PIXEL_OPERADOR(+, Suma)
+PIXEL_OPERADOR(-, Resta)
+PIXEL_OPERADOR(*, Producto)
+PIXEL_OPERADOR(&, YBit)
+PIXEL_OPERADOR(>>, Desplazamiento)
+#undef PIXEL_OPERADOR
+
+template <typename A, typename B>
+auto maximo(const A& a, const B& b) { return binaria<Maximo>(comoExpresion(a), comoExpresion(b)); }
+
+// |a - b|, como cv::absdiff
+template <typename A, typename B>
+auto diferenciaAbsoluta(const Expresion<A>& a, const Expresion<B>& b) {
+    return binaria<DiferenciaAbsoluta>(a.derivada(), b.derivada());
+}
+
+template <typename A>
+auto absoluto(const Expresion<A>& a) { return Unaria<A, Absoluto>(a.derivada(), Absoluto()); }
+
+// Recorte a [0, 255], como saturate_cast<uchar> en un paso intermedio
+template <typename A>
+auto saturar(const Expresion<A>& a) { return Unaria<A, Saturar>(a.derivada(), Saturar()); }
+
+// 255 donde a > umbral y 0 en el resto, como cv::threshold con THRESH_BINARY
+template <typename A>
+auto umbral(const Expresion<A>& a, int valorUmbral) { return Unaria<A, UmbralBinario>(a.derivada(), UmbralBinario{valorUmbral}); }
+
+// Destino de una expresión en una evaluación conjunta
+template <typename E>
+struct Asignacion {
+    cv::Mat& destino;
+    E expresion;
+};
+
+template <typename E>
+Asignacion<E> asignar(cv::Mat& destino, const Expresion<E>& expresion) { return {destino, expresion.derivada()}; }
+
+// Prepara un destino de uchar con `tamano` elementos por fila y devuelve su vista de un
+// canal. Un destino que ya tiene esos elementos (por ejemplo, un panel del mosaico o
+// un plano del pool) se escribe en su lugar sin reasignar.
+inline cv::Mat prepararDestino(cv::Mat& destino, cv::Size tamano) {
+    if (destino.depth() != CV_8U || destino.rows != tamano.height || destino.cols * destino.channels() != tamano.width) {
+        destino.create(tamano, CV_8UC1);
+    }
+    return destino.reshape(1);
+}
+
+template <typename... E, std::size_t... I>
+void evaluarFila(int y, int ancho, cv::Mat* planos, std::index_sequence<I...>, const Asignacion<E>&... asignaciones) {
+    auto filas = std::make_tuple(asignaciones.expresion.fila(y)...);
+    uchar* destinos[] = {planos[I].template ptr<uchar>(y)...};
+    // Los destinos no se solapan con las entradas: sin esta indicación el compilador
+    // agrega una comprobación de solapamiento por cada par y con varias salidas desiste
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+    for (int x = 0; x < ancho; x++) {
+        ((destinos[I][x] = cv::saturate_cast<uchar>(std::get<I>(filas)(x))), ...);
+    }
+}
+
+// Evalúa varias expresiones del mismo tamaño en un solo recorrido: cada píxel de las
+// entradas se lee una vez (en caché) para todas las salidas. Ningún destino puede
+// ser a la vez una entrada de las expresiones.
+template <typename... E>
+void evaluar(const Asignacion<E>&... asignaciones) {
+    const cv::Size tamano = std::get<0>(std::forward_as_tuple(asignaciones...)).expresion.tamano();
+    CV_Assert(!tamano.empty());
+    for (const cv::Size& otro : {asignaciones.expresion.tamano()...}) CV_Assert(otro == tamano);
+    cv::Mat planos[] = {prepararDestino(asignaciones.destino, tamano)...};
+    cv::parallel_for_(cv::Range(0, tamano.height), [&](const cv::Range& rango) {
+        for (int y = rango.start; y < rango.end; y++) {
+            evaluarFila(y, tamano.width, planos, std::index_sequence_for<E...>(), asignaciones...);
+        }
+    });
+}
+
+template <typename E>
+void evaluar(const Expresion<E>& expresion, cv::Mat& destino) {
+    evaluar(asignar(destino, expresion));
+}
+
+template <typename... E>
+void evaluar(const std::tuple<Asignacion<E>...>& asignaciones) {
+    std::apply([](const auto&... asignacion) { evaluar(asignacion...); }, asignaciones);
+}
+
+// Bytes por elemento que mueve una evaluación conjunta, para comparar con la misma cadena
+// sin fusionar: cada imagen leída cuenta una vez aunque la usen varias expresiones (las
+// lecturas repetidas salen de caché), más un byte escrito por cada destino
+template <typename... E>
+int bytesPorElemento(const Asignacion<E>&... asignaciones) {
+    std::vector<std::pair<const uchar*, int>> leidas;
+    auto registrar = [&leidas](const uchar* datos, int bytes) {
+        for (auto& leida : leidas) {
+            if (leida.first == datos) {
+                leida.second = std::max(leida.second, bytes);
+                return;
+            }
+        }
+        leidas.emplace_back(datos, bytes);
+    };
+    (asignaciones.expresion.lecturas(registrar), ...);
+    int bytes = int(sizeof...(E));
+    for (const auto& leida : leidas) bytes += leida.second;
+    return bytes;
+}
+
+template <typename... E>
+int bytesPorElemento(const std::tuple<Asignacion<E>...>& asignaciones) {
+    return std::apply([](const auto&... asignacion) { return bytesPorElemento(asignacion...); }, asignaciones);
+}
+
+}  // namespace pixel
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef POOL_BUFFERS_HPP
+#define POOL_BUFFERS_HPP
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Pool de buffers de imagen para que las etapas no reserven sus propios buffers en
+// régimen estable. Un buffer está libre cuando solo el pool lo referencia (refcount 1):
+// los Mat entregados pueden viajar por colas entre hilos y vuelven solos al
+// pool cuando el último consumidor los suelta.
+class PoolBuffers {
+public:
+    // Devuelve un Mat del tamaño y tipo pedidos, reutilizando un buffer libre si hay
+    cv::Mat obtener(cv::Size tamano, int tipo) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (cv::Mat& buffer : buffers_) {
+            if (buffer.size() == tamano && buffer.type() == tipo && libre(buffer)) {
+                return buffer;
+            }
+        }
+        buffers_.emplace_back(tamano, tipo);
+        buffersCreados_++;
+        return buffers_.back();
+    }
+
+    cv::Mat obtenerComo(const cv::Mat& referencia) { return obtener(referencia.size(), referencia.type()); }
+
+    // Buffers que el pool tuvo que crear porque no había uno libre. No incluye las
+    // reservas que hace OpenCV fuera del pool: esas las cuenta AsignadorContador.
+    long buffersCreados() const { return buffersCreados_.load(); }
+
+private:
+    static bool libre(const cv::Mat& buffer) {
+        return buffer.u && CV_XADD(&buffer.u->refcount, 0) == 1;
+    }
+
+    std::vector<cv::Mat> buffers_;
+    std::mutex mutex_;
+    std::atomic<long> buffersCreados_{0};
+};
+
+// Asignador de cv::Mat que delega en el estándar y cuenta cada buffer que reserva.
+// Instalado como asignador por defecto, ve todas las reservas de datos de Mat del
+// proceso, incluidas las temporales internas de las funciones de OpenCV, así que
+// mide las asignaciones reales por frame y no solo los fallos del pool.
+class AsignadorContador : public cv::MatAllocator {
+public:
+    // Instala el contador como asignador por defecto de cv::Mat y lo devuelve
+    static AsignadorContador& instalar() {
+        static AsignadorContador asignador;
+        cv::Mat::setDefaultAllocator(&asignador);
+        return asignador;
+    }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override {
+        if (!data) reservas_++; // Con datos del usuario no se reserva nada
+        return base_->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* datos, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return base_->allocate(datos, flags, usageFlags);
+    }
+
+    // Los UMatData los crea el asignador estándar y vuelven a él; esto solo cubre otros casos
+    void deallocate(cv::UMatData* datos) const override { base_->deallocate(datos); }
+
+    // Número total de buffers de Mat reservados desde la instalación
+    long reservas() const { return reservas_.load(); }
+
+private:
+    AsignadorContador() : base_(cv::Mat::getStdAllocator()) {}
+
+    cv::MatAllocator* base_;
+    mutable std::atomic<long> reservas_{0};
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef POOL_HILOS_HPP
+#define POOL_HILOS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de hilos con robo de trabajo. Cada hilo tiene su propia cola: las tareas
+// que encola un hilo del pool van a su cola (LIFO, con los datos aún en caché) y
+// un hilo sin trabajo roba por el otro extremo de las colas ajenas. Las tareas
+// no deben lanzar excepciones.
+class PoolHilos {
+public:
+    explicit PoolHilos(unsigned hilos = std::thread::hardware_concurrency()) {
+        if (hilos == 0) hilos = 1;
+        for (unsigned i = 0; i < hilos; i++) colas_.push_back(std::make_unique<Cola>());
+        for (unsigned i = 0; i < hilos; i++) hilos_.emplace_back(&PoolHilos::trabajar, this, i);
+    }
+
+    // Termina las tareas pendientes y detiene los hilos
+    ~PoolHilos() {
+        {
+            std::lock_guard<std::mutex> lock(mutexEspera_);
+            detener_ = true;
+        }
+        hayTrabajo_.notify_all();
+        for (auto& hilo : hilos_) hilo.join();
+    }
+
+    PoolHilos(const PoolHilos&) = delete;
+    PoolHilos& operator=(const PoolHilos&) = delete;
+
+    unsigned hilos() const { return unsigned(hilos_.size()); }
+
+    void encolar(std::function<void()> tarea) {
+        size_t indice = poolActual() == this ? indiceActual() : siguiente_++ % colas_.size();
+        enCola_++;
+        sinTerminar_++;
+        {
+            std::lock_guard<std::mutex> lock(colas_[indice]->mutex);
+            colas_[indice]->tareas.push_back(std::move(tarea));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutexEspera_);
+        }
+        hayTrabajo_.notify_one();
+    }
+
+    // Espera a que terminen todas las tareas encoladas hasta el momento (y las que estas encolen)
+    void esperar() {
+        std::unique_lock<std::mutex> lock(mutexEspera_);
+        terminaron_.wait(lock, [this] { return sinTerminar_.load() == 0; });
+    }
+
+private:
+    struct Cola {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tareas;
+    };
+
+    static PoolHilos*& poolActual() {
+        static thread_local PoolHilos* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& indiceActual() {
+        static thread_local size_t indice = 0;
+        return indice;
+    }
+
+    // Toma una tarea de la cola propia (por detrás) o la roba de otra (por delante)
+    bool tomar(size_t indice, std::function<void()>& tarea) {
+        {
+            Cola& propia = *colas_[indice];
+            std::lock_guard<std::mutex> lock(propia.mutex);
+            if (!propia.tareas.empty()) {
+                tarea = std::move(propia.tareas.back());
+                propia.tareas.pop_back();
+                enCola_--;
+                return true;
+            }
+        }
+        for (size_t i = 1; i < colas_.size(); i++) {
+            Cola& ajena = *colas_[(indice + i) % colas_.size()];
+            std::lock_guard<std::mutex> lock(ajena.mutex);
+            if (!ajena.tareas.empty()) {
+                tarea = std::move(ajena.tareas.front());
+                ajena.tareas.pop_front();
+                enCola_--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void trabajar(size_t indice) {
+        poolActual() = this;
+        indiceActual() = indice;
+        while (true) {
+            std::function<void()> tarea;
+            if (tomar(indice, tarea)) {
+                tarea();
+                if (--sinTerminar_ == 0) {
+                    std::lock_guard<std::mutex> lock(mutexEspera_);
+                    terminaron_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutexEspera_);
+            hayTrabajo_.wait(lock, [this] { return detener_ || enCola_.load() > 0; });
+            if (detener_ && enCola_.load() <= 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Cola>> colas_;
+    std::vector<std::thread> hilos_;
+    std::atomic<size_t> siguiente_{0};
+    std::atomic<long> enCola_{0};
+    std::atomic<long> sinTerminar_{0};
+    std::mutex mutexEspera_;
+    std::condition_variable hayTrabajo_;
+    std::condition_variable terminaron_;
+    bool detener_ = false;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef SALIDA_HPP
+#define SALIDA_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "cola_acotada.hpp"
+#include "pool_buffers.hpp"
+
+// Destino de los frames ya compuestos. Cada canal es una ventana o un archivo de
+// salida; los programas entregan sus resultados sin saber cuál de los dos es.
+class SalidaFrames {
+public:
+    virtual ~SalidaFrames() = default;
+
+    // Declara un canal antes de usarlo (en pantalla crea la ventana con esas opciones)
+    virtual void prepararCanal(const std::string& canal, int opciones = cv::WINDOW_AUTOSIZE) = 0;
+
+    // Entrega un frame al canal. El sink puede retenerlo hasta codificarlo, así que
+    // el llamador no debe volver a escribir en él (un buffer nuevo del pool por frame)
+    virtual void enviar(const std::string& canal, const cv::Mat& frame) = 0;
+
+    // Igual que enviar, para frames cuyo buffer el llamador reutiliza en el siguiente
+    // fotograma: si el sink lo retiene, primero lo copia a un buffer propio
+    virtual void enviarCopia(const std::string& canal, const cv::Mat& frame) { enviar(canal, frame); }
+
+    // Indica si hay ventanas (y con ellas trackbars y teclado vía waitKey)
+    virtual bool interactiva() const = 0;
+
+    // Frames que no llegaron a escribirse porque el escritor iba atrasado
+    virtual long descartados() const { return 0; }
+};
+
+// Salida en pantalla con highgui; debe usarse desde el hilo principal
+class SalidaVentanas : public SalidaFrames {
+public:
+    void prepararCanal(const std::string& canal, int opciones) override { cv::namedWindow(canal, opciones); }
+    void enviar(const std::string& canal, const cv::Mat& frame) override { cv::imshow(canal, frame); }
+    bool interactiva() const override { return true; }
+    ~SalidaVentanas() override { cv::destroyAllWindows(); }
+};
+
+// Salida sin pantalla: los frames pasan por una cola acotada a un hilo escritor que
+// los codifica en archivos locales, un video (VideoWriter) o una secuencia PNG por
+// canal. Enviar nunca espera a la codificación; si el escritor se atrasa, la cola
+// descarta los frames más viejos y se cuentan en descartados(). Con sinDescartes,
+// enviar espera al escritor en lugar de descartar.
+class SalidaAsincrona : public SalidaFrames {
+public:
+    enum class Formato { Video, MJPEG, PNG };
+
+    SalidaAsincrona(Formato formato, const std::string& directorio, double fps, size_t capacidad = 8,
+                    bool sinDescartes = false)
+        : formato_(formato), directorio_(directorio), fps_(fps > 0 ? fps : 30.0), cola_(capacidad, sinDescartes) {
+        std::filesystem::create_directories(directorio_);
+        escritor_ = std::thread(&SalidaAsincrona::escribir, this);
+    }
+
+    ~SalidaAsincrona() override {
+        cola_.cerrar();
+        escritor_.join(); // Termina de escribir lo que quedó en la cola
+    }
+
+    void prepararCanal(const std::string&, int) override {}
+
+    void enviar(const std::string& canal, const cv::Mat& frame) override { cola_.insertar({canal, frame}); }
+
+    void enviarCopia(const std::string& canal, const cv::Mat& frame) override {
+        cv::Mat copia = pool_.obtenerComo(frame);
+        frame.copyTo(copia);
+        enviar(canal, copia);
+    }
+
+    bool interactiva() const override { return false; }
+    long descartados() const override { return long(cola_.descartados()); }
+
+private:
+    struct FrameSalida {
+        std::string canal;
+        cv::Mat frame;
+    };
+
+    // Estado de escritura de un canal: su video abierto o el número del siguiente PNG
+    struct Canal {
+        cv::VideoWriter video;
+        long frames = 0;
+    };
+
+    // Nombre de archivo a partir del nombre del canal (sin espacios ni símbolos)
+    static std::string nombreArchivo(const std::string& canal) {
+        std::string nombre;
+        for (char c : canal) nombre += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        return nombre;
+    }
+
+    void escribir() {
+        std::map<std::string, Canal> canales;
+        FrameSalida salida;
+        while (cola_.extraer(salida)) {
+            Canal& canal = canales[salida.canal];
+            std::string base = directorio_ + "/" + nombreArchivo(salida.canal);
+            try {
+                if (formato_ == Formato::PNG) {
+                    char numero[16];
+                    std::snprintf(numero, sizeof(numero), "_%06ld.png", canal.frames);
+                    cv::imwrite(base + numero, salida.frame);
+                } else {
+                    if (!canal.video.isOpened()) {
+                        bool mjpeg = formato_ == Formato::MJPEG;
+                        int codec = mjpeg ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G') : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+                        canal.video.open(base + (mjpeg ? ".avi" : ".mp4"), codec, fps_, salida.frame.size(),
+                                         salida.frame.channels() == 3);
+                        if (!canal.video.isOpened()) throw std::runtime_error("no se pudo abrir el video");
+                    }
+                    canal.video.write(salida.frame);
+                }
+            } catch (const std::exception& error) {
+                std::cerr << "Error al escribir el canal " << salida.canal << ": " << error.what() << std::endl;
+            }
+            canal.frames++;
+            salida.frame.release(); // Devuelve el buffer a su pool antes de esperar el siguiente
+        }
+    }
+
+    Formato formato_;
+    std::string directorio_;
+    double fps_;
+    PoolBuffers pool_;
+    ColaAcotada<FrameSalida> cola_;
+    std::thread escritor_;
+};
+
+// Crea la salida a partir de la opción --salida: "ventana" (por defecto), o
+// "video:DIR", "mjpeg:DIR" o "png:DIR" para escribir sin pantalla en el directorio DIR.
+// `capacidad` es el número de frames que pueden esperar al escritor antes de descartar;
+// con sinDescartes el llamador espera al escritor y se escriben todos los frames.
+inline std::unique_ptr<SalidaFrames> crearSalida(const std::string& especificacion, double fps, size_t capacidad = 8,
+                                                 bool sinDescartes = false) {
+    if (especificacion.empty() || especificacion == "ventana") return std::make_unique<SalidaVentanas>();
+
+    size_t separador = especificacion.find(':');
+    std::string tipo = especificacion.substr(0, separador);
+    std::string directorio = separador == std::string::npos ? "." : especificacion.substr(separador + 1);
+    if (tipo == "video") return std::make_unique<SalidaAsincrona>(SalidaAsincrona::Formato::Video, directorio, fps, capacidad, sinDescartes);
+    if (tipo == "mjpeg") return std::make_unique<SalidaAsincrona>(SalidaAsincrona::Formato::MJPEG, directorio, fps, capacidad, sinDescartes);
+    if (tipo == "png") return std::make_unique<SalidaAsincrona>(SalidaAsincrona::Formato::PNG, directorio, fps, capacidad, sinDescartes);
+    throw std::invalid_argument("Salida desconocida: " + especificacion + " (ventana|video:DIR|mjpeg:DIR|png:DIR)");
+}
+
+// Sin ventanas no hay tecla ESC: SIGINT y SIGTERM piden terminar de forma ordenada
+inline std::atomic<bool>& detencionSolicitada() {
+    static std::atomic<bool> solicitada(false);
+    return solicitada;
+}
+
+inline void instalarSenalesDetencion() {
+    detencionSolicitada(); // Inicializa la bandera antes de que un manejador pueda usarla
+    auto manejador = [](int) { detencionSolicitada().store(true); };
+    std::signal(SIGINT, manejador);
+    std::signal(SIGTERM, manejador);
+}
+
+#endif
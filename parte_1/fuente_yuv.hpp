@@ -0,0 +1,158 @@
+#ifndef FUENTE_YUV_HPP
+#define FUENTE_YUV_HPP
+
+#include <opencv2/core.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include "pool_buffers.hpp"
+#include "realce.hpp"
+
+// Fuente de frames YUV 4:2:0 ya decodificados: Y4M o YUV crudo (I420), desde
+// un archivo local o desde un pipe ("-" es la entrada estándar). Los archivos
+// se mapean en memoria y cada frame es una vista de solo lectura sobre el mapa,
+// sin copias ni conversión a BGR; desde un pipe se lee a un buffer del pool.
+class FuenteYUV {
+public:
+    // Si tamanoCrudo está vacío la entrada es Y4M; si no, YUV crudo de ese tamaño
+    explicit FuenteYUV(const std::string& ruta, cv::Size tamanoCrudo = cv::Size())
+        : ruta_(ruta), tamano_(tamanoCrudo) {
+        fd_ = ruta == "-" ? STDIN_FILENO : ::open(ruta.c_str(), O_RDONLY);
+        if (fd_ < 0) throw std::runtime_error("No se pudo abrir " + ruta);
+
+        struct stat info;
+        if (fstat(fd_, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* mapa = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (mapa == MAP_FAILED) {
+                cerrarDescriptor();
+                throw std::runtime_error("No se pudo mapear " + ruta);
+            }
+            madvise(mapa, info.st_size, MADV_SEQUENTIAL);
+            mapa_ = static_cast<const uchar*>(mapa);
+            tamanoMapa_ = info.st_size;
+        }
+
+        y4m_ = tamano_.empty();
+        if (y4m_) leerCabecera();
+        if (tamano_.width <= 0 || tamano_.height <= 0 || tamano_.width % 2 || tamano_.height % 2) {
+            liberar();
+            throw std::runtime_error("Tamaño de frame no válido en " + ruta);
+        }
+        bytesFrame_ = size_t(tamano_.area()) * 3 / 2;
+    }
+
+    ~FuenteYUV() { liberar(); }
+
+    FuenteYUV(const FuenteYUV&) = delete;
+    FuenteYUV& operator=(const FuenteYUV&) = delete;
+
+    cv::Size tamano() const { return tamano_; }
+
+    // Lee el siguiente frame; la luma es una vista sobre el buffer I420 y la croma no se toca
+    bool leer(FrameLuma& frame, PoolBuffers& pool) {
+        if (y4m_) {
+            std::string linea;
+            if (!leerLinea(linea)) return false;
+            if (linea.compare(0, 5, "FRAME") != 0) throw std::runtime_error("Frame Y4M corrupto en " + ruta_);
+        }
+
+        cv::Mat i420;
+        if (mapa_) {
+            if (posicion_ + bytesFrame_ > tamanoMapa_) return false;
+            // Vista de solo lectura: el mapa es PROT_READ y nadie escribe sobre el frame de entrada
+            i420 = cv::Mat(tamano_.height * 3 / 2, tamano_.width, CV_8UC1, const_cast<uchar*>(mapa_ + posicion_));
+            posicion_ += bytesFrame_;
+        } else {
+            i420 = pool.obtener(cv::Size(tamano_.width, tamano_.height * 3 / 2), CV_8UC1);
+            if (!leerBytes(i420.data, bytesFrame_)) return false;
+        }
+
+        frame = FrameLuma();
+        frame.i420 = i420;
+        frame.y = i420.rowRange(0, tamano_.height);
+        return true;
+    }
+
+private:
+    // Cabecera: "YUV4MPEG2 W<ancho> H<alto> [F..] [I..] [A..] [C<croma>] ..."
+    void leerCabecera() {
+        std::string linea;
+        if (!leerLinea(linea) || linea.compare(0, 9, "YUV4MPEG2") != 0) {
+            liberar();
+            throw std::runtime_error("Cabecera Y4M no válida en " + ruta_);
+        }
+        size_t inicio = 9;
+        while (inicio < linea.size()) {
+            size_t fin = linea.find(' ', inicio + 1);
+            if (fin == std::string::npos) fin = linea.size();
+            std::string campo = linea.substr(inicio + 1, fin - inicio - 1);
+            if (!campo.empty()) {
+                if (campo[0] == 'W') tamano_.width = std::atoi(campo.c_str() + 1);
+                else if (campo[0] == 'H') tamano_.height = std::atoi(campo.c_str() + 1);
+                else if (campo[0] == 'C' && !croma420de8Bits(campo.substr(1))) {
+                    liberar();
+                    throw std::runtime_error("Solo se admite croma 4:2:0 de 8 bits, no " + campo + " en " + ruta_);
+                }
+            }
+            inicio = fin;
+        }
+    }
+
+    // Etiquetas Y4M de croma 4:2:0 con muestras de 8 bits (las variantes solo cambian la
+    // posición de la croma); C420p10 y similares usan dos bytes por muestra
+    static bool croma420de8Bits(const std::string& croma) {
+        return croma == "420" || croma == "420jpeg" || croma == "420paldv" || croma == "420mpeg2";
+    }
+
+    bool leerLinea(std::string& linea) {
+        linea.clear();
+        if (mapa_) {
+            while (posicion_ < tamanoMapa_ && mapa_[posicion_] != '\n') linea += char(mapa_[posicion_++]);
+            if (posicion_ >= tamanoMapa_) return false;
+            posicion_++;
+            return true;
+        }
+        char c;
+        while (::read(fd_, &c, 1) == 1) {
+            if (c == '\n') return true;
+            linea += c;
+        }
+        return false;
+    }
+
+    bool leerBytes(uchar* destino, size_t bytes) {
+        while (bytes > 0) {
+            ssize_t leidos = ::read(fd_, destino, bytes);
+            if (leidos <= 0) return false;
+            destino += leidos;
+            bytes -= size_t(leidos);
+        }
+        return true;
+    }
+
+    void cerrarDescriptor() {
+        if (fd_ > STDIN_FILENO) ::close(fd_);
+        fd_ = -1;
+    }
+
+    void liberar() {
+        if (mapa_) munmap(const_cast<uchar*>(mapa_), tamanoMapa_);
+        mapa_ = nullptr;
+        cerrarDescriptor();
+    }
+
+    std::string ruta_;
+    cv::Size tamano_;
+    bool y4m_ = true;
+    int fd_ = -1;
+    const uchar* mapa_ = nullptr;
+    size_t tamanoMapa_ = 0;
+    size_t posicion_ = 0;
+    size_t bytesFrame_ = 0;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef METRICAS_HPP
+#define METRICAS_HPP
+
+#include <opencv2/core.hpp>
+#include <json/json.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Histograma de latencias con cubetas logarítmicas (cada una un 20% más ancha
+// que la anterior, de 1 us a ~30 s). Registrar es un incremento atómico, así que
+// varias tareas del pool pueden medir la misma etapa sin bloquearse. Los
+// percentiles se reportan como el límite superior de su cubeta.
+class HistogramaLatencia {
+public:
+    static constexpr int cubetas = 96;
+
+    struct Resumen {
+        long muestras = 0;
+        double p50Ms = 0.0, p99Ms = 0.0, maximoMs = 0.0;
+    };
+
+    void registrar(double ms) {
+        cuentas_[indice(ms)].fetch_add(1, std::memory_order_relaxed);
+        double maximo = maximoMs_.load(std::memory_order_relaxed);
+        while (ms > maximo && !maximoMs_.compare_exchange_weak(maximo, ms, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Resume la ventana actual y empieza una nueva
+    Resumen tomarYReiniciar() {
+        std::array<long, cubetas> cuentas;
+        Resumen resumen;
+        for (int i = 0; i < cubetas; i++) {
+            cuentas[i] = cuentas_[i].exchange(0, std::memory_order_relaxed);
+            resumen.muestras += cuentas[i];
+        }
+        resumen.maximoMs = maximoMs_.exchange(0.0, std::memory_order_relaxed);
+        resumen.p50Ms = std::min(percentil(cuentas, resumen.muestras, 0.50), resumen.maximoMs);
+        resumen.p99Ms = std::min(percentil(cuentas, resumen.muestras, 0.99), resumen.maximoMs);
+        return resumen;
+    }
+
+private:
+    static double limite(int cubeta) { return 0.001 * std::pow(1.2, cubeta); }
+
+    static int indice(double ms) {
+        if (ms <= 0.001) return 0;
+        int cubeta = int(std::ceil(std::log(ms / 0.001) / std::log(1.2)));
+        return std::min(cubeta, cubetas - 1);
+    }
+
+    static double percentil(const std::array<long, cubetas>& cuentas, long muestras, double fraccion) {
+        if (muestras == 0) return 0.0;
+        long objetivo = long(std::ceil(fraccion * muestras)), acumulado = 0;
+        for (int i = 0; i < cubetas; i++) {
+            acumulado += cuentas[i];
+            if (acumulado >= objetivo) return limite(i);
+        }
+        return limite(cubetas - 1);
+    }
+
+    std::array<std::atomic<long>, cubetas> cuentas_{};
+    std::atomic<double> maximoMs_{0.0};
+};
+
+// Temporizador de alcance: mide desde su creación hasta que sale del bloque
+class TemporizadorEscopado {
+public:
+    explicit TemporizadorEscopado(HistogramaLatencia& histograma)
+        : histograma_(histograma), inicio_(cv::getTickCount()) {}
+    ~TemporizadorEscopado() { histograma_.registrar((cv::getTickCount() - inicio_) * 1000.0 / cv::getTickFrequency()); }
+
+    TemporizadorEscopado(const TemporizadorEscopado&) = delete;
+    TemporizadorEscopado& operator=(const TemporizadorEscopado&) = delete;
+
+private:
+    HistogramaLatencia& histograma_;
+    int64 inicio_;
+};
+
+// Conjunto de histogramas por etapa más un contador de frames para el FPS por
+// ventana. Las etapas se crean durante la configuración; luego solo se registran.
+class Metricas {
+public:
+    HistogramaLatencia& etapa(const std::string& nombre) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& histograma = etapas_[nombre];
+        if (!histograma) histograma = std::make_unique<HistogramaLatencia>();
+        return *histograma;
+    }
+
+    void contarFrame() { frames_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Vuelca la ventana de `segundos` como JSON y la reinicia
+    Json::Value volcar(double segundos) {
+        Json::Value valor;
+        long frames = frames_.exchange(0, std::memory_order_relaxed);
+        valor["fps"] = segundos > 0 ? frames / segundos : 0.0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [nombre, histograma] : etapas_) {
+            HistogramaLatencia::Resumen resumen = histograma->tomarYReiniciar();
+            Json::Value etapa;
+            etapa["muestras"] = Json::Int64(resumen.muestras);
+            etapa["p50_ms"] = resumen.p50Ms;
+            etapa["p99_ms"] = resumen.p99Ms;
+            etapa["max_ms"] = resumen.maximoMs;
+            valor["etapas"][nombre] = etapa;
+        }
+        return valor;
+    }
+
+private:
+    std::map<std::string, std::unique_ptr<HistogramaLatencia>> etapas_;
+    std::mutex mutex_;
+    std::atomic<long> frames_{0};
+};
+
+#endif
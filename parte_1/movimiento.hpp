@@ -0,0 +1,156 @@
+#ifndef MOVIMIENTO_HPP
+#define MOVIMIENTO_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video.hpp>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "pixel.hpp"
+
+// Interfaz común de los detectores de movimiento. Cada detector mide su propio
+// costo para poder elegir, por cámara, el backend más barato que sea suficiente.
+class DetectorMovimiento {
+public:
+    virtual ~DetectorMovimiento() = default;
+
+    // Actualiza el modelo de fondo con el frame gris y escribe la máscara de movimiento
+    void detectar(const cv::Mat& gris, cv::Mat& movimiento) {
+        int64 inicio = cv::getTickCount();
+        aplicar(gris, movimiento);
+        ticks_ += cv::getTickCount() - inicio;
+        ++frames_;
+    }
+
+    virtual const char* nombre() const = 0;
+
+    long frames() const { return frames_; }
+    double costoMedioMs() const { return frames_ ? ticks_ * 1000.0 / cv::getTickFrequency() / frames_ : 0.0; }
+
+protected:
+    virtual void aplicar(const cv::Mat& gris, cv::Mat& movimiento) = 0;
+
+private:
+    int64 ticks_ = 0;
+    long frames_ = 0;
+};
+
+// Substracción de fondo MOG2 (el comportamiento original)
+class DetectorMOG2 : public DetectorMovimiento {
+public:
+    DetectorMOG2() : pBackSub_(cv::createBackgroundSubtractorMOG2()) {}
+    const char* nombre() const override { return "mog2"; }
+
+protected:
+    void aplicar(const cv::Mat& gris, cv::Mat& movimiento) override { pBackSub_->apply(gris, movimiento); }
+
+private:
+    cv::Ptr<cv::BackgroundSubtractor> pBackSub_;
+};
+
+// Diferencia contra el frame anterior, umbralizada
+// absdiff seguido de threshold (THRESH_BINARY), como una sola expresión por píxel
+inline auto expresionDiferenciaUmbral(const cv::Mat& actual, const cv::Mat& anterior, int umbral) {
+    return pixel::umbral(pixel::diferenciaAbsoluta(pixel::leer<uchar>(actual), pixel::leer<uchar>(anterior)), umbral);
+}
+
+class DetectorDiferencia : public DetectorMovimiento {
+public:
+    explicit DetectorDiferencia(int umbral = 10) : umbral_(umbral) {}
+    const char* nombre() const override { return "diferencia"; }
+
+protected:
+    void aplicar(const cv::Mat& gris, cv::Mat& movimiento) override {
+        if (frameAnterior_.empty()) gris.copyTo(frameAnterior_); // Inicializar con el primer frame
+        pixel::evaluar(expresionDiferenciaUmbral(gris, frameAnterior_, umbral_), movimiento);
+        gris.copyTo(frameAnterior_); // Reutiliza el buffer: mismo tamaño y tipo
+    }
+
+private:
+    int umbral_;
+    cv::Mat frameAnterior_;
+};
+
+// Fondo por promedio móvil en punto fijo 8.8: fondo += (x - fondo) / 2^desplazamiento.
+// Actualiza el modelo en el lugar y genera la máscara en la misma pasada; el
+// cuerpo del bucle no tiene saltos para que el compilador lo vectorice.
+class DetectorFondoPromedio : public DetectorMovimiento {
+public:
+    explicit DetectorFondoPromedio(int desplazamiento = 5, int umbral = 20)
+        : desplazamiento_(desplazamiento), umbral_(umbral) {}
+    const char* nombre() const override { return "promedio"; }
+
+protected:
+    void aplicar(const cv::Mat& gris, cv::Mat& movimiento) override {
+        CV_Assert(gris.type() == CV_8UC1);
+        if (fondo_.size() != gris.size()) gris.convertTo(fondo_, CV_16U, 256); // Inicializar con el primer frame
+        movimiento.create(gris.size(), CV_8UC1);
+
+        const int k = desplazamiento_, umbral = umbral_;
+        for (int i = 0; i < gris.rows; i++) {
+            const uchar* x = gris.ptr<uchar>(i);
+            ushort* f = fondo_.ptr<ushort>(i);
+            uchar* m = movimiento.ptr<uchar>(i);
+            for (int j = 0; j < gris.cols; j++) {
+                int fondo = f[j];
+                int diferencia = std::abs(int(x[j]) - (fondo >> 8));
+                m[j] = uchar(-(diferencia > umbral));
+                f[j] = ushort(fondo + (((int(x[j]) << 8) - fondo) >> k));
+            }
+        }
+    }
+
+private:
+    int desplazamiento_;
+    int umbral_;
+    cv::Mat fondo_;
+};
+
+// Fondo por mediana aproximada: cada píxel del fondo se acerca en 1 al valor
+// observado. Más robusto que el promedio ante objetos que pasan rápido.
+class DetectorFondoMediana : public DetectorMovimiento {
+public:
+    explicit DetectorFondoMediana(int umbral = 20) : umbral_(umbral) {}
+    const char* nombre() const override { return "mediana"; }
+
+protected:
+    void aplicar(const cv::Mat& gris, cv::Mat& movimiento) override {
+        CV_Assert(gris.type() == CV_8UC1);
+        if (fondo_.size() != gris.size()) gris.copyTo(fondo_); // Inicializar con el primer frame
+        movimiento.create(gris.size(), CV_8UC1);
+
+        const int umbral = umbral_;
+        for (int i = 0; i < gris.rows; i++) {
+            const uchar* x = gris.ptr<uchar>(i);
+            uchar* f = fondo_.ptr<uchar>(i);
+            uchar* m = movimiento.ptr<uchar>(i);
+            for (int j = 0; j < gris.cols; j++) {
+                int valor = x[j], fondo = f[j];
+                m[j] = uchar(-(std::abs(valor - fondo) > umbral));
+                f[j] = uchar(fondo + (valor > fondo) - (valor < fondo));
+            }
+        }
+    }
+
+private:
+    int umbral_;
+    cv::Mat fondo_;
+};
+
+// Crea un detector por nombre: mog2, diferencia, promedio o mediana
+inline std::unique_ptr<DetectorMovimiento> crearDetectorMovimiento(const std::string& nombre) {
+    if (nombre == "mog2") return std::make_unique<DetectorMOG2>();
+    if (nombre == "diferencia") return std::make_unique<DetectorDiferencia>();
+    if (nombre == "promedio") return std::make_unique<DetectorFondoPromedio>();
+    if (nombre == "mediana") return std::make_unique<DetectorFondoMediana>();
+    throw std::invalid_argument("Detector de movimiento desconocido: " + nombre);
+}
+
+// Indica si `nombre` es un backend que crearDetectorMovimiento conoce
+inline bool existeDetectorMovimiento(const std::string& nombre) {
+    return nombre == "mog2" || nombre == "diferencia" || nombre == "promedio" || nombre == "mediana";
+}
+
+#endif
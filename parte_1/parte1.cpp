@@ -11,6 +11,25 @@
 #include <array>
 #include <stdexcept>
 #include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cola_acotada.hpp"
+#include "pool_hilos.hpp"
+#include "pool_buffers.hpp"
+#include "realce.hpp"
+#include "movimiento.hpp"
+#include "fuente_yuv.hpp"
+#include "metricas.hpp"
+#include "mosaico.hpp"
+#include "salida.hpp"
 
 using namespace std;
 using namespace cv;
@@ -35,212 +54,602 @@ std::string obtenerURLStreamYouTube(const std::string& youtubeUrl) {
     return ejecutarComando(comando.c_str());
 }
 
-// Variables globales para parámetros de los filtros
-int gammaEntero = 10; // Valor entero para el parámetro gamma (inicializado en 10)
-double gammaValor = 1.0; // Valor inicial para la corrección gamma
-
-// Función de callback para los trackbars
-void funcionGamma(int valor, void *) { gammaValor = valor / 10.0; }
-
-// Función que aplica ecualización de histograma
-Mat aplicarEcualizacionHistograma(Mat& frame) {
-    Mat ycrcb;
-    cvtColor(frame, ycrcb, COLOR_BGR2YCrCb);
-    vector<Mat> canales;
-    split(ycrcb, canales);
-    equalizeHist(canales[0], canales[0]);
-    merge(canales, ycrcb);
-    Mat resultado;
-    cvtColor(ycrcb, resultado, COLOR_YCrCb2BGR);
-    return resultado;
-}
-
-// Función que aplica el filtro CLAHE
-Mat aplicarCLAHE(Mat& frame) {
-    Mat lab;
-    cvtColor(frame, lab, COLOR_BGR2Lab);
-    vector<Mat> lab_planes(3);
-    split(lab, lab_planes);
-    Ptr<CLAHE> clahe = createCLAHE();
-    clahe->setClipLimit(4);
-    Mat resultado;
-    clahe->apply(lab_planes[0], resultado);
-    resultado.copyTo(lab_planes[0]);
-    merge(lab_planes, lab);
-    Mat resultado_final;
-    cvtColor(lab, resultado_final, COLOR_Lab2BGR);
-    return resultado_final;
+// Función que indica si un texto termina con el sufijo dado
+bool terminaEn(const string& texto, const string& sufijo) {
+    return texto.size() >= sufijo.size() && texto.compare(texto.size() - sufijo.size(), sufijo.size(), sufijo) == 0;
 }
 
-// Función que aplica la corrección gamma
-Mat aplicarCorreccionGamma(Mat& frame, double gamma) {
-    Mat resultado;
-    Mat tablaLUT(1, 256, CV_8U);
-    uchar* p = tablaLUT.ptr();
-    for (int i = 0; i < 256; ++i)
-        p[i] = saturate_cast<uchar>(pow(i / 255.0, gamma) * 255.0);
-    LUT(frame, tablaLUT, resultado);
-    return resultado;
-}
+// Función de callback para los trackbars: cada flujo tiene su propio valor gamma
+void funcionGamma(int valor, void* gammaValor) { static_cast<atomic<double>*>(gammaValor)->store(valor / 10.0); }
 
 // Función para mostrar los FPS en el frame
-void mostrarFPS(Mat& frame, double fps) {
+void mostrarFPS(Mosaico& mosaico, double fps) {
     string textoFPS = "FPS: " + to_string(int(fps));
-    putText(frame, textoFPS, Point(10, 30), FONT_HERSHEY_SIMPLEX, 1, Scalar(255, 255, 255), 2);
+    mosaico.etiquetar(0, textoFPS, Point(10, 30), 1, 2); // El texto cambia a lo sumo una vez por segundo
 }
 
-// Función para detectar movimiento
-void detectarMovimiento(Mat& frameActual, Mat& frameAnterior, Mat& movimiento, Ptr<BackgroundSubtractor> pBackSub) {
-    Mat resta;
-    absdiff(frameActual, frameAnterior, resta);
-    threshold(resta, movimiento, 10, 255, THRESH_BINARY);
-    pBackSub->apply(frameActual, movimiento);
-    frameAnterior = frameActual.clone();
+// Capacidad de la cola de salida de cada rama: pocas posiciones para que la latencia quede acotada
+const size_t capacidadCola = 2;
+// Sin descartes la rama espera lugar en su cola: más posiciones para que el bucle de
+// visualización, que la vacía una vez por --espera, no frene el procesamiento
+const size_t capacidadColaSinDescartes = 16;
+
+// Frame que la captura reparte a las ramas: planos de luma/croma, FPS e instante de captura
+struct FrameCapturado {
+    FrameLuma planos;
+    double fps = 0.0;
+    int64 instante = 0;
+};
+
+struct Flujo;
+
+// Rama de procesamiento: un filtro más su detección de movimiento. Sus frames se
+// procesan como tareas del pool compartido, de a una por vez para respetar el
+// orden del modelo de fondo; si llega un frame mientras la rama está ocupada,
+// reemplaza al pendiente y siempre se procesa el más reciente.
+struct Rama {
+    string ventana;
+    Flujo& flujo;
+    MotorRealce motor;
+    unique_ptr<DetectorMovimiento> detector;
+    PoolBuffers pool; // Buffers propios de la rama (lumas, filtrados y combinadas)
+    Mat movimiento;
+    Mosaico mosaico{2, 1}; // Realce a la izquierda, máscara de movimiento a la derecha
+    ColaAcotada<Mat> salida;
+
+    // Histogramas de las etapas de la rama (pertenecen a las métricas del flujo)
+    HistogramaLatencia* tiempoRealce = nullptr;
+    HistogramaLatencia* tiempoMovimiento = nullptr;
+    HistogramaLatencia* tiempoComposicion = nullptr;
+
+    mutex mutexPendiente;
+    FrameCapturado pendiente;
+    bool hayPendiente = false;
+    bool programada = false; // Hay una tarea de esta rama en el pool
+    bool sinDescartes; // El pendiente no se reemplaza: la captura espera a que la rama lo tome
+    bool detenida = false; // Falló al procesar un frame: no recibe más
+    condition_variable pendienteTomado;
+
+    Rama(const string& ventana, Flujo& flujo, FiltroRealce filtro, unique_ptr<DetectorMovimiento> detector, bool sinDescartes)
+        : ventana(ventana), flujo(flujo), motor(filtro), detector(move(detector)), salida(sinDescartes ? capacidadColaSinDescartes : capacidadCola, sinDescartes),
+          sinDescartes(sinDescartes) {}
+};
+
+// Flujo de video: su fuente, su hilo de captura y el estado propio de sus ramas
+struct Flujo {
+    string entrada;
+    string prefijo; // Prefijo de las ventanas cuando hay varios flujos
+    // Archivo regular: se procesan y entregan todos sus frames, sin descartar ninguno,
+    // para que una ejecución sin conexión sea reproducible. Los pipes y dispositivos
+    // son fuentes en vivo y conservan el frame más reciente, como el stream.
+    bool sinDescartes = false;
+
+    // Fuente de frames: YUV ya decodificado (sin pasar por BGR) o VideoCapture
+    PoolBuffers poolCaptura;
+    VideoCapture video;
+    unique_ptr<FuenteYUV> fuenteYUV;
+    Mat frameLeido; // Solo lo usa el hilo de captura: la decodificación reutiliza su buffer
+    function<bool(FrameLuma&)> leerFrame;
+
+    vector<unique_ptr<Rama>> ramas;
+    int nivelMovimiento = 0; // Nivel de la pirámide de luma en el que detectan movimiento las ramas
+    int gammaEntero = 10; // Valor entero para el parámetro gamma (inicializado en 10)
+    atomic<double> gammaValor{1.0}; // Valor para la corrección gamma (se lee desde las tareas del pool)
+
+    thread hiloCaptura;
+    atomic<bool> capturaTerminada{false};
+
+    // Latencias por etapa del flujo; los punteros evitan buscar la etapa en cada frame
+    Metricas metricas;
+    HistogramaLatencia* tiempoDecodificacion = &metricas.etapa("decodificacion");
+    HistogramaLatencia* tiempoRedimension = &metricas.etapa("redimension");
+    HistogramaLatencia* tiempoPiramide = &metricas.etapa("piramide");
+    HistogramaLatencia* tiempoCapturaResultado = &metricas.etapa("captura_a_resultado");
+};
+
+// Función que crea una rama del flujo y registra los histogramas de sus etapas
+void agregarRama(Flujo& flujo, const string& ventana, const string& etiqueta, FiltroRealce filtro,
+                 const string& backendMovimiento) {
+    auto rama = make_unique<Rama>(flujo.prefijo + ventana, flujo, filtro, crearDetectorMovimiento(backendMovimiento),
+                                  flujo.sinDescartes);
+    rama->tiempoRealce = &flujo.metricas.etapa("realce_" + etiqueta);
+    rama->tiempoMovimiento = &flujo.metricas.etapa("movimiento_" + etiqueta);
+    rama->tiempoComposicion = &flujo.metricas.etapa("composicion");
+    flujo.ramas.push_back(move(rama));
 }
 
-int main(int argc, char* args[]) {
-    // URL del stream de video en vivo de YouTube
-    string youtubeUrl = "https://www.youtube.com/watch?v=tWu34gp3Rmk";
-    // Obtener el enlace directo del video en vivo de YouTube
-    string streamUrl;
-    try {
-        streamUrl = obtenerURLStreamYouTube(youtubeUrl);
-    } catch (const std::exception& e) {
-        cerr << "Error al obtener la URL del stream de YouTube: " << e.what() << endl;
-        return -1;
+// Frames capturados hasta el momento por todos los flujos, para calcular asignaciones por frame
+atomic<long> framesCapturados(0);
+
+// Función que lee un frame de VideoCapture, lo redimensiona y extrae su luma
+bool leerFrameVideo(Flujo& flujo, FrameLuma& frame) {
+    {
+        TemporizadorEscopado temporizador(*flujo.tiempoDecodificacion);
+        flujo.video >> flujo.frameLeido; // Capturar frame del video
     }
+    if (flujo.frameLeido.empty()) return false;
 
-    if (streamUrl.empty()) {
-        cerr << "Error al obtener la URL del stream de YouTube!" << endl;
-        return -1;
+    // Redimensionar el frame una sola vez
+    TemporizadorEscopado temporizador(*flujo.tiempoRedimension);
+    Size tamanoPequeno(800, 600); // Cambiar este tamaño según sea necesario
+    Mat frameColor = flujo.poolCaptura.obtener(tamanoPequeno, flujo.frameLeido.type());
+    resize(flujo.frameLeido, frameColor, tamanoPequeno);
+
+    // Extraer la luma una sola vez: es el gris del movimiento y la base de los tres filtros
+    extraerLuma(frameColor, frame, flujo.poolCaptura);
+    return true;
+}
+
+// Función que abre la fuente de un flujo: .y4m, .yuv crudo, "-" (pipe), video local o, vacía, el stream de YouTube
+bool abrirFlujo(Flujo& flujo, const string& entrada, Size tamanoCrudo) {
+    flujo.entrada = entrada.empty() ? "youtube" : entrada;
+    // Solo un archivo regular se lee a su propio ritmo; pipes, /dev/video* y URLs son en vivo
+    std::error_code error;
+    flujo.sinDescartes = entrada != "-" && filesystem::is_regular_file(entrada, error);
+
+    bool entradaYUV = entrada == "-" || terminaEn(entrada, ".y4m") || terminaEn(entrada, ".yuv");
+    if (terminaEn(entrada, ".yuv") && tamanoCrudo.empty()) {
+        cerr << "Un archivo YUV crudo requiere --tam=ANCHOxALTO: " << entrada << endl;
+        return false;
+    }
+
+    if (entradaYUV) {
+        try {
+            // El tamaño crudo solo aplica a .yuv y al pipe: un .y4m trae el suyo en la cabecera
+            flujo.fuenteYUV = make_unique<FuenteYUV>(entrada, terminaEn(entrada, ".y4m") ? Size() : tamanoCrudo);
+        } catch (const std::exception& e) {
+            cerr << "Error al abrir la entrada YUV: " << e.what() << endl;
+            return false;
+        }
+        // Un frame corrupto termina solo este flujo: el hilo de captura no debe lanzar
+        flujo.leerFrame = [&flujo](FrameLuma& frame) {
+            TemporizadorEscopado temporizador(*flujo.tiempoDecodificacion);
+            try {
+                return flujo.fuenteYUV->leer(frame, flujo.poolCaptura);
+            } catch (const std::exception& e) {
+                cerr << "Error al leer " << flujo.entrada << ": " << e.what() << endl;
+                return false;
+            }
+        };
+        return true;
+    }
+
+    string streamUrl = entrada;
+    if (entrada.empty()) {
+        // URL del stream de video en vivo de YouTube
+        string youtubeUrl = "https://www.youtube.com/watch?v=tWu34gp3Rmk";
+        // Obtener el enlace directo del video en vivo de YouTube
+        try {
+            streamUrl = obtenerURLStreamYouTube(youtubeUrl);
+        } catch (const std::exception& e) {
+            cerr << "Error al obtener la URL del stream de YouTube: " << e.what() << endl;
+            return false;
+        }
+
+        if (streamUrl.empty()) {
+            cerr << "Error al obtener la URL del stream de YouTube!" << endl;
+            return false;
+        }
     }
 
     // Manejo de Video
-    VideoCapture video(streamUrl);
+    flujo.video.open(streamUrl);
 
     // Verificamos si la cámara se pudo abrir
-    if (!video.isOpened()) {
-        cerr << "Error al abrir el stream de video!" << endl;
-        return -1;
+    if (!flujo.video.isOpened()) {
+        cerr << "Error al abrir el stream de video: " << flujo.entrada << endl;
+        return false;
     }
+    flujo.leerFrame = [&flujo](FrameLuma& frame) { return leerFrameVideo(flujo, frame); };
+    return true;
+}
 
-    // Crear ventanas para mostrar los resultados
-    namedWindow("Original y Movimiento", WINDOW_AUTOSIZE);
-    namedWindow("Histograma Ecualizado y Movimiento", WINDOW_AUTOSIZE);
-    namedWindow("CLAHE y Movimiento", WINDOW_AUTOSIZE);
-    namedWindow("Correccion Gamma y Movimiento", WINDOW_AUTOSIZE);
-
-    // Crear trackbars para ajustar parámetros en la ventana "Corrección Gamma y Movimiento"
-    createTrackbar("Gamma", "Correccion Gamma y Movimiento", &gammaEntero, 50, funcionGamma);
-
-    Mat frameColor, frameAnteriorColor, movimientoOriginal;
-    Mat frameAnteriorHistograma, movimientoHistograma;
-    Mat frameAnteriorCLAHE, movimientoCLAHE;
-    Mat frameAnteriorGamma, movimientoGamma;
-
-    // Crear objetos para substracción de fondo
-    Ptr<BackgroundSubtractor> pBackSub = createBackgroundSubtractorMOG2();
-    Ptr<BackgroundSubtractor> pBackSubHistograma = createBackgroundSubtractorMOG2();
-    Ptr<BackgroundSubtractor> pBackSubCLAHE = createBackgroundSubtractorMOG2();
-    Ptr<BackgroundSubtractor> pBackSubGamma = createBackgroundSubtractorMOG2();
-    
-    // Variables para calcular FPS
-    double fps = 0.0;
-    int conteoFrames = 0;
-    double inicio = getTickCount();
+// Coloca la máscara de movimiento en su panel, a la resolución de la pantalla. Una máscara
+// de un nivel reducido se pasa a BGR a baja resolución y se amplía por vecino más cercano
+// directamente sobre el panel: la única pasada a resolución completa es esa escritura.
+void colocarMascara(Mosaico& mosaico, int indice, const Mat& mascara, PoolBuffers& pool) {
+    Mat panel = mosaico.panel(indice);
+    if (mascara.size() == panel.size()) {
+        mosaico.colocar(indice, mascara);
+        return;
+    }
+    Mat mascaraBGR = pool.obtener(mascara.size(), CV_8UC3);
+    cvtColor(mascara, mascaraBGR, COLOR_GRAY2BGR);
+    resize(mascaraBGR, panel, panel.size(), 0, 0, INTER_NEAREST);
+}
 
-    // Bucle principal
-    while (true) {
-        video >> frameColor; // Capturar frame del video
-        if (frameColor.empty()) break; // Salir si no hay más frames
+// Procesa un frame en una rama: filtro, movimiento y composición lado a lado
+void procesarFrame(Rama& rama, const FrameCapturado& frame) {
+    // Cada frame usa un lienzo nuevo del pool (el anterior puede seguir en la cola de salida).
+    // El motor escribe el BGR realzado directamente en el panel izquierdo; el frame
+    // compartido no se modifica.
+    rama.mosaico.preparar(frame.planos.y.size(), rama.pool);
+    Mat gris, filtrado = rama.mosaico.panel(0);
+    const double gamma = rama.flujo.gammaValor.load();
+    // El movimiento se detecta en el nivel configurado de la pirámide, con el mismo
+    // filtro de la rama aplicado a esa luma reducida; la luma completa solo se realza
+    // si el movimiento va a resolución completa
+    const int nivel = rama.flujo.nivelMovimiento;
+    {
+        TemporizadorEscopado temporizador(*rama.tiempoRealce);
+        rama.motor.procesar(frame.planos, gamma, rama.pool, nivel == 0 ? &gris : nullptr, &filtrado);
+        if (nivel > 0) rama.motor.realzarLuma(frame.planos.luma(nivel), gamma, rama.pool, gris);
+    }
+    {
+        TemporizadorEscopado temporizador(*rama.tiempoMovimiento);
+        rama.detector->detectar(gris, rama.movimiento);
+    }
 
-        // Redimensionar el frameColor una sola vez
-        Size tamanoPequeno(800, 600); // Cambiar este tamaño según sea necesario
-        resize(frameColor, frameColor, tamanoPequeno);
+    // Completar la imagen combinada con su movimiento
+    {
+        TemporizadorEscopado temporizador(*rama.tiempoComposicion);
+        rama.mosaico.colocar(0, filtrado); // No copia si el motor ya escribió en el panel
+        colocarMascara(rama.mosaico, 1, rama.movimiento, rama.pool);
 
         // Mostrar los FPS
-        conteoFrames++;
-        double actual = (getTickCount() - inicio) / getTickFrequency();
-        fps = conteoFrames / actual;
+        mostrarFPS(rama.mosaico, frame.fps);
+    }
+
+    rama.salida.insertar(rama.mosaico.lienzo());
+    rama.flujo.tiempoCapturaResultado->registrar((getTickCount() - frame.instante) * 1000.0 / getTickFrequency());
+}
+
+// Tarea del pool: procesa el frame pendiente de la rama y se vuelve a encolar si llegó otro
+void ejecutarRama(Rama& rama, PoolHilos& pool) {
+    FrameCapturado frame;
+    {
+        lock_guard<mutex> lock(rama.mutexPendiente);
+        frame = move(rama.pendiente);
+        rama.hayPendiente = false;
+    }
+    rama.pendienteTomado.notify_one();
+
+    // Las tareas del pool no deben lanzar: un error (un CV_Assert, o MOG2 ante un cambio
+    // de tamaño) se informa y detiene solo esta rama
+    bool fallo = false;
+    try {
+        procesarFrame(rama, frame);
+    } catch (const std::exception& e) {
+        cerr << "Error en la rama " << rama.ventana << ", se detiene: " << e.what() << endl;
+        fallo = true;
+    }
 
-        mostrarFPS(frameColor, fps);
+    lock_guard<mutex> lock(rama.mutexPendiente);
+    if (fallo) {
+        rama.detenida = true;
+        rama.hayPendiente = false;
+        rama.pendiente = FrameCapturado();
+        rama.programada = false;
+        rama.pendienteTomado.notify_all();
+    } else if (rama.hayPendiente) {
+        pool.encolar([&rama, &pool] { ejecutarRama(rama, pool); });
+    } else {
+        rama.programada = false;
+    }
+}
+
+// Indica si la rama tiene un frame en proceso o pendiente
+bool ramaOcupada(Rama& rama) {
+    lock_guard<mutex> lock(rama.mutexPendiente);
+    return rama.programada || rama.hayPendiente;
+}
 
-        // Convertir a escala de grises para movimiento
-        Mat frameGris;
-        cvtColor(frameColor, frameGris, COLOR_BGR2GRAY);
+// Entrega un frame a una rama; si la rama está ocupada queda como pendiente, reemplazando al anterior
+// (o, sin descartes, espera a que la rama tome el pendiente anterior). Devuelve false si la rama
+// está detenida.
+bool entregarFrame(Rama& rama, const FrameCapturado& frame, PoolHilos& pool) {
+    unique_lock<mutex> lock(rama.mutexPendiente);
+    if (rama.sinDescartes) rama.pendienteTomado.wait(lock, [&rama] { return !rama.hayPendiente || rama.detenida; });
+    if (rama.detenida) return false;
+    rama.pendiente = frame;
+    rama.hayPendiente = true;
+    if (!rama.programada) {
+        rama.programada = true;
+        pool.encolar([&rama, &pool] { ejecutarRama(rama, pool); });
+    }
+    return true;
+}
 
-        if (frameAnteriorColor.empty()) {
-            frameAnteriorColor = frameGris.clone(); // Inicializar el primer frame
-            cout << "Inicializa el primer frame ..." << endl;
+// Etapa de captura de un flujo: obtiene cada frame de su fuente y lo reparte a sus ramas
+void capturarFrames(Flujo& flujo, PoolHilos& pool, const atomic<bool>& detener) {
+    // Variables para calcular FPS en ventanas de un segundo (un promedio desde el inicio oculta las pausas)
+    double fps = 0.0;
+    int conteoFrames = 0;
+    int64 inicioVentana = getTickCount();
+
+    while (!detener) {
+        FrameCapturado frame;
+        if (!flujo.leerFrame(frame.planos)) break; // Salir si no hay más frames
+        if (flujo.nivelMovimiento > 0) {
+            // Una sola pirámide por frame, compartida por todas las ramas del flujo
+            TemporizadorEscopado temporizador(*flujo.tiempoPiramide);
+            construirPiramide(frame.planos, flujo.nivelMovimiento, flujo.poolCaptura);
+        }
+        frame.instante = getTickCount();
+        flujo.metricas.contarFrame();
+
+        conteoFrames++;
+        double actual = (frame.instante - inicioVentana) / getTickFrequency();
+        if (actual >= 1.0) {
+            fps = conteoFrames / actual;
+            conteoFrames = 0;
+            inicioVentana = frame.instante;
         }
+        frame.fps = fps;
 
-        // Detectar movimiento en el frame original
-        detectarMovimiento(frameGris, frameAnteriorColor, movimientoOriginal, pBackSub);
+        bool entregado = false;
+        for (auto& rama : flujo.ramas) {
+            if (entregarFrame(*rama, frame, pool)) entregado = true;
+        }
+        if (!entregado) break; // Todas las ramas del flujo se detuvieron
+        framesCapturados++;
+    }
+    flujo.capturaTerminada = true;
+}
 
-        // Aplicar filtros adicionales a la imagen en color
-        Mat histogramaEcualizado = aplicarEcualizacionHistograma(frameColor);
-        Mat resultadoCLAHE = aplicarCLAHE(frameColor);
-        Mat correccionGamma = aplicarCorreccionGamma(frameColor, gammaValor);
+int main(int argc, char* args[]) {
+    // Uso: parte1 [entrada[@backend]...] [--tam=ANCHOxALTO] [--hilos=N] [--movimiento=mog2|diferencia|promedio|mediana]
+    //             [--metricas=archivo.jsonl] [--periodo-metricas=segundos]
+    //             [--salida=ventana|video:DIR|mjpeg:DIR|png:DIR] [--espera=MS] [--nivel-movimiento=0|1|2]
+    // Cada entrada es un flujo: un .y4m, un .yuv crudo (requiere --tam), "-" para leer
+    // Y4M (o YUV crudo con --tam) desde un pipe, o cualquier video local. Sin entradas
+    // se usa el stream de YouTube. Todos los flujos comparten un pool de --hilos hilos.
+    // --movimiento es el backend de movimiento por defecto; una entrada puede elegir el
+    // suyo con el sufijo @backend (por ejemplo camara1.y4m@diferencia o -@promedio), para
+    // usar en cada cámara el más barato que alcance.
+    // Las latencias por etapa se agregan a --metricas como una línea JSON por período.
+    // Sin ventanas los resultados se codifican en DIR desde un hilo escritor y el programa
+    // termina al acabar las entradas o con SIGINT/SIGTERM. --espera es la pausa del bucle
+    // de visualización (23 ms por defecto); no limita el procesamiento, que va en el pool.
+    // Los archivos regulares se procesan completos: la captura espera a las ramas y cada
+    // resultado llega a la salida, así una ejecución sin conexión es reproducible. Las
+    // fuentes en vivo (pipe, dispositivo o stream) entregan siempre el frame más reciente
+    // y descartan el resto, sin acumular latencia.
+    // --nivel-movimiento elige la resolución de la detección de movimiento: 0 completa,
+    // 1 la mitad (por defecto) o 2 un cuarto; la visualización siempre es a resolución completa.
+    AsignadorContador& asignador = AsignadorContador::instalar(); // Antes de crear cualquier Mat
+    string backendMovimiento = "mog2";
+    string rutaMetricas;
+    double periodoMetricas = 5.0;
+    vector<string> entradas;
+    Size tamanoCrudo;
+    unsigned hilos = thread::hardware_concurrency();
+    string especificacionSalida = "ventana";
+    int espera = 23;
+    int nivelMovimiento = 1;
+    for (int i = 1; i < argc; i++) {
+        string argumento = args[i];
+        if (argumento.rfind("--movimiento=", 0) == 0) {
+            backendMovimiento = argumento.substr(13);
+        } else if (argumento.rfind("--tam=", 0) == 0) {
+            if (sscanf(argumento.c_str() + 6, "%dx%d", &tamanoCrudo.width, &tamanoCrudo.height) != 2) {
+                cerr << "Tamaño no válido: " << argumento << endl;
+                return -1;
+            }
+        } else if (argumento.rfind("--metricas=", 0) == 0) {
+            rutaMetricas = argumento.substr(11);
+        } else if (argumento.rfind("--periodo-metricas=", 0) == 0) {
+            periodoMetricas = atof(argumento.c_str() + 19);
+        } else if (argumento.rfind("--hilos=", 0) == 0) {
+            hilos = unsigned(max(1, atoi(argumento.c_str() + 8)));
+        } else if (argumento.rfind("--salida=", 0) == 0) {
+            especificacionSalida = argumento.substr(9);
+        } else if (argumento.rfind("--espera=", 0) == 0) {
+            espera = max(0, atoi(argumento.c_str() + 9));
+        } else if (argumento.rfind("--nivel-movimiento=", 0) == 0) {
+            nivelMovimiento = atoi(argumento.c_str() + 19);
+            if (nivelMovimiento < 0 || nivelMovimiento > nivelMaximoPiramide) {
+                cerr << "Nivel de movimiento no válido (0 a " << nivelMaximoPiramide << "): " << argumento << endl;
+                return -1;
+            }
+        } else if (argumento == "-" || argumento.rfind("-@", 0) == 0 || argumento[0] != '-') {
+            entradas.push_back(argumento);
+        } else {
+            cerr << "Argumento desconocido: " << argumento << endl;
+            return -1;
+        }
+    }
+    if (entradas.empty()) entradas.push_back("");
+
+    // Backend de movimiento de cada entrada: el sufijo @backend o, sin él, --movimiento.
+    // Solo se separa un sufijo que nombra un backend (una URL puede contener '@')
+    vector<string> backends(entradas.size(), backendMovimiento);
+    for (size_t i = 0; i < entradas.size(); i++) {
+        size_t arroba = entradas[i].rfind('@');
+        if (arroba != string::npos && existeDetectorMovimiento(entradas[i].substr(arroba + 1))) {
+            backends[i] = entradas[i].substr(arroba + 1);
+            entradas[i].erase(arroba);
+        }
+    }
 
-        // Convertir a escala de grises para detección de movimiento en filtros
-        Mat histogramaGris, claheGris, gammaGris;
-        cvtColor(histogramaEcualizado, histogramaGris, COLOR_BGR2GRAY);
-        cvtColor(resultadoCLAHE, claheGris, COLOR_BGR2GRAY);
-        cvtColor(correccionGamma, gammaGris, COLOR_BGR2GRAY);
+    // Flujos de video: cada uno con sus ramas, filtros y detectores de movimiento
+    vector<unique_ptr<Flujo>> flujos;
+    for (size_t i = 0; i < entradas.size(); i++) {
+        auto flujo = make_unique<Flujo>();
+        if (entradas.size() > 1) flujo->prefijo = "[" + to_string(i) + "] ";
+        flujo->nivelMovimiento = nivelMovimiento;
+        if (!abrirFlujo(*flujo, entradas[i], tamanoCrudo)) return -1;
+
+        try {
+            agregarRama(*flujo, "Original y Movimiento", "original", FiltroRealce::Ninguno, backends[i]);
+            agregarRama(*flujo, "Histograma Ecualizado y Movimiento", "ecualizacion", FiltroRealce::Ecualizacion, backends[i]);
+            agregarRama(*flujo, "CLAHE y Movimiento", "clahe", FiltroRealce::CLAHE, backends[i]);
+            agregarRama(*flujo, "Correccion Gamma y Movimiento", "gamma", FiltroRealce::Gamma, backends[i]);
+        } catch (const std::exception& e) {
+            cerr << e.what() << endl;
+            return -1;
+        }
+        flujos.push_back(move(flujo));
+    }
 
-        // Detectar movimiento en los frames con filtros aplicados
-        if (frameAnteriorHistograma.empty()) frameAnteriorHistograma = histogramaGris.clone();
-        if (frameAnteriorCLAHE.empty()) frameAnteriorCLAHE = claheGris.clone();
-        if (frameAnteriorGamma.empty()) frameAnteriorGamma = gammaGris.clone();
+    // Salida de los resultados: ventanas o archivos escritos por un hilo aparte
+    unique_ptr<SalidaFrames> salida;
+    try {
+        bool sinDescartes = all_of(flujos.begin(), flujos.end(), [](const unique_ptr<Flujo>& flujo) { return flujo->sinDescartes; });
+        salida = crearSalida(especificacionSalida, flujos[0]->video.isOpened() ? flujos[0]->video.get(CAP_PROP_FPS) : 30.0, 8,
+                             sinDescartes);
+    } catch (const std::exception& e) {
+        cerr << e.what() << endl;
+        return -1;
+    }
+    if (!salida->interactiva()) instalarSenalesDetencion();
 
-        detectarMovimiento(histogramaGris, frameAnteriorHistograma, movimientoHistograma, pBackSubHistograma);
-        detectarMovimiento(claheGris, frameAnteriorCLAHE, movimientoCLAHE, pBackSubCLAHE);
-        detectarMovimiento(gammaGris, frameAnteriorGamma, movimientoGamma, pBackSubGamma);
+    // Crear ventanas para mostrar los resultados
+    for (auto& flujo : flujos) {
+        for (auto& rama : flujo->ramas) {
+            salida->prepararCanal(rama->ventana, WINDOW_AUTOSIZE);
+        }
 
-        // Crear una imagen combinada para cada filtro y su movimiento
-        Mat combinadaOriginal(frameColor.rows, frameColor.cols * 2, frameColor.type());
-        Mat combinadaHistograma(histogramaEcualizado.rows, histogramaEcualizado.cols * 2, histogramaEcualizado.type());
-        Mat combinadaCLAHE(resultadoCLAHE.rows, resultadoCLAHE.cols * 2, resultadoCLAHE.type());
-        Mat combinadaGamma(correccionGamma.rows, correccionGamma.cols * 2, correccionGamma.type());
+        // Crear trackbars para ajustar parámetros en la ventana "Corrección Gamma y Movimiento"
+        if (salida->interactiva()) {
+            createTrackbar("Gamma", flujo->prefijo + "Correccion Gamma y Movimiento", &flujo->gammaEntero, 50,
+                           funcionGamma, &flujo->gammaValor);
+        }
+    }
 
-        // Copiar las imágenes originales y de movimiento a las combinadas
-        frameColor.copyTo(combinadaOriginal(Rect(0, 0, frameColor.cols, frameColor.rows)));
-        cvtColor(movimientoOriginal, movimientoOriginal, COLOR_GRAY2BGR); // Convertir a BGR para que coincida el tipo
-        movimientoOriginal.copyTo(combinadaOriginal(Rect(frameColor.cols, 0, movimientoOriginal.cols, movimientoOriginal.rows)));
+    // Un hilo de captura por flujo; filtros y movimiento de todos los flujos van al pool
+    // compartido. El hilo principal solo entrega resultados (highgui no es seguro entre hilos).
+    PoolHilos pool(hilos);
+    cout << "Procesando " << flujos.size() << " flujo(s) con " << pool.hilos() << " hilos" << endl;
+    atomic<bool> detener(false);
+    for (auto& flujo : flujos) {
+        flujo->hiloCaptura = thread(capturarFrames, ref(*flujo), ref(pool), cref(detener));
+    }
 
-        histogramaEcualizado.copyTo(combinadaHistograma(Rect(0, 0, histogramaEcualizado.cols, histogramaEcualizado.rows)));
-        cvtColor(movimientoHistograma, movimientoHistograma, COLOR_GRAY2BGR);
-        movimientoHistograma.copyTo(combinadaHistograma(Rect(histogramaEcualizado.cols, 0, movimientoHistograma.cols, movimientoHistograma.rows)));
+    // Volcado periódico de métricas en JSON (una línea por período)
+    ofstream archivoMetricas;
+    if (!rutaMetricas.empty()) {
+        archivoMetricas.open(rutaMetricas, ios::app);
+        if (!archivoMetricas) {
+            cerr << "No se pudo abrir el archivo de métricas: " << rutaMetricas << endl;
+        }
+    }
+    Json::StreamWriterBuilder escritorJson;
+    escritorJson["indentation"] = "";
+    Metricas metricasVisualizacion;
+    HistogramaLatencia& tiempoVisualizacion = metricasVisualizacion.etapa("visualizacion");
 
-        resultadoCLAHE.copyTo(combinadaCLAHE(Rect(0, 0, resultadoCLAHE.cols, resultadoCLAHE.rows)));
-        cvtColor(movimientoCLAHE, movimientoCLAHE, COLOR_GRAY2BGR);
-        movimientoCLAHE.copyTo(combinadaCLAHE(Rect(resultadoCLAHE.cols, 0, movimientoCLAHE.cols, movimientoCLAHE.rows)));
+    // Asignaciones reales de cv::Mat por frame (las del pool y las internas de OpenCV)
+    long reservasPrevias = 0, buffersPoolPrevios = 0, framesPrevios = 0;
+    int64 ultimoReporte = getTickCount(), ultimoReporteMetricas = getTickCount();
 
-        correccionGamma.copyTo(combinadaGamma(Rect(0, 0, correccionGamma.cols, correccionGamma.rows)));
-        cvtColor(movimientoGamma, movimientoGamma, COLOR_GRAY2BGR);
-        movimientoGamma.copyTo(combinadaGamma(Rect(correccionGamma.cols, 0, movimientoGamma.cols, movimientoGamma.rows)));
+    // Bucle principal: mostrar el resultado más reciente de cada rama
+    while (true) {
+        bool activos = false;
+        for (auto& flujo : flujos) {
+            for (auto& rama : flujo->ramas) {
+                // Lienzos propios de cada frame: no hace falta copiarlos. Sin descartes se
+                // entregan todos en orden; si no, solo el más reciente
+                Mat combinada;
+                if (rama->sinDescartes) {
+                    while (rama->salida.intentarExtraer(combinada)) {
+                        TemporizadorEscopado temporizador(tiempoVisualizacion);
+                        salida->enviar(rama->ventana, combinada);
+                    }
+                } else if (rama->salida.extraerUltimo(combinada)) {
+                    TemporizadorEscopado temporizador(tiempoVisualizacion);
+                    salida->enviar(rama->ventana, combinada);
+                }
+            }
+            if (!flujo->capturaTerminada) activos = true;
+        }
+        if (!activos) {
+            // Todos los flujos terminaron: esperar a que las ramas procesen sus últimos
+            // frames y entregar en orden todo lo que quedó en sus colas antes de salir
+            bool ocupadas = true;
+            while (ocupadas) {
+                ocupadas = false;
+                for (auto& flujo : flujos) {
+                    for (auto& rama : flujo->ramas) {
+                        if (ramaOcupada(*rama)) ocupadas = true;
+                        Mat combinada;
+                        while (rama->salida.intentarExtraer(combinada)) salida->enviar(rama->ventana, combinada);
+                    }
+                }
+                if (ocupadas) this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            pool.esperar();
+            break;
+        }
 
-        // Mostrar imágenes combinadas
-        if (!combinadaOriginal.empty()) {
-            imshow("Original y Movimiento", combinadaOriginal);
+        if (getTickCount() - ultimoReporte > getTickFrequency()) {
+            long buffersPool = 0;
+            for (auto& flujo : flujos) {
+                buffersPool += flujo->poolCaptura.buffersCreados();
+                for (auto& rama : flujo->ramas) buffersPool += rama->pool.buffersCreados();
+            }
+            long reservas = asignador.reservas();
+            long frames = framesCapturados.load();
+            if (frames > framesPrevios) {
+                cout << "Asignaciones de Mat por frame: " << double(reservas - reservasPrevias) / (frames - framesPrevios)
+                     << " (buffers nuevos del pool: " << double(buffersPool - buffersPoolPrevios) / (frames - framesPrevios)
+                     << ")" << endl;
+            }
+            reservasPrevias = reservas;
+            buffersPoolPrevios = buffersPool;
+            framesPrevios = frames;
+            ultimoReporte = getTickCount();
         }
-        if (!combinadaHistograma.empty()) {
-            imshow("Histograma Ecualizado y Movimiento", combinadaHistograma);
+
+        // Histogramas de latencia por etapa y FPS de cada flujo en la última ventana
+        double segundos = (getTickCount() - ultimoReporteMetricas) / getTickFrequency();
+        if (segundos > periodoMetricas) {
+            Json::Value reporte;
+            reporte["segundos"] = segundos;
+            for (auto& flujo : flujos) {
+                Json::Value valor = flujo->metricas.volcar(segundos);
+                const Json::Value& latencia = valor["etapas"]["captura_a_resultado"];
+                double framesProcesados = latencia["muestras"].asDouble() / flujo->ramas.size() / segundos;
+                valor["entrada"] = flujo->entrada;
+                valor["fps_procesados"] = framesProcesados;
+                cout << flujo->entrada << ": " << framesProcesados << " frames/s, latencia p50 "
+                     << latencia["p50_ms"].asDouble() << " ms, p99 " << latencia["p99_ms"].asDouble()
+                     << " ms, máxima " << latencia["max_ms"].asDouble() << " ms" << endl;
+                reporte["flujos"].append(valor);
+            }
+            reporte["visualizacion"] = metricasVisualizacion.volcar(segundos)["etapas"]["visualizacion"];
+            if (archivoMetricas.is_open()) {
+                archivoMetricas << Json::writeString(escritorJson, reporte) << endl;
+            }
+            ultimoReporteMetricas = getTickCount();
         }
-        if (!combinadaCLAHE.empty()) {
-            imshow("CLAHE y Movimiento", combinadaCLAHE);
+
+        if (salida->interactiva()) {
+            // Salir si se presiona la tecla ESC (waitKey necesita al menos 1 ms para atender las ventanas)
+            if (waitKey(max(1, espera)) == 27) break;
+        } else {
+            if (detencionSolicitada()) break;
+            this_thread::sleep_for(chrono::milliseconds(max(1, espera)));
         }
-        if (!combinadaGamma.empty()) {
-            imshow("Correccion Gamma y Movimiento", combinadaGamma);
+    }
+
+    detener = true;
+    for (auto& flujo : flujos) {
+        // Una rama sin descartes puede estar esperando lugar en su cola: al cerrarla termina su frame
+        for (auto& rama : flujo->ramas) rama->salida.cerrar();
+    }
+    for (auto& flujo : flujos) {
+        flujo->hiloCaptura.join();
+    }
+    pool.esperar();
+
+    // Reportar el costo del detector de cada rama para comparar backends
+    for (auto& flujo : flujos) {
+        for (auto& rama : flujo->ramas) {
+            cout << rama->ventana << ": " << rama->detector->nombre() << " "
+                 << rama->detector->costoMedioMs() << " ms/frame (" << rama->detector->frames() << " frames)" << endl;
         }
+    }
 
-        // Salir si se presiona la tecla ESC
-        if (waitKey(23) == 27) break;
+    if (salida->descartados() > 0) {
+        cout << "Frames descartados por la salida: " << salida->descartados() << endl;
     }
 
-    // Liberar el video y destruir todas las ventanas
-    video.release();
-    destroyAllWindows();
+    // Liberar los videos y cerrar la salida (destruye las ventanas o termina de escribir los archivos)
+    for (auto& flujo : flujos) {
+        flujo->video.release();
+    }
+    salida.reset();
 
     return 0;
 }
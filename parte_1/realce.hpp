@@ -0,0 +1,239 @@
+#ifndef REALCE_HPP
+#define REALCE_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+#include <tuple>
+#include "pixel.hpp"
+#include "pool_buffers.hpp"
+
+// Frame descompuesto una sola vez en luma y croma. La luma Y usa los mismos
+// coeficientes que BGR2GRAY, así que sirve directamente como imagen gris para la
+// detección de movimiento. Una entrada BGR llena color, y, cr y cb; una entrada
+// YUV 4:2:0 llena i420 e y (vista sobre sus primeras filas) y deja el resto vacío.
+// `piramide` guarda la luma a 1/2 y 1/4 de resolución cuando se construye (ver
+// construirPiramide); los niveles no pedidos quedan vacíos.
+struct FrameLuma {
+    cv::Mat color;
+    cv::Mat y, cr, cb;
+    cv::Mat i420;
+    cv::Mat piramide[2];
+
+    // Luma del nivel pedido: 0 es la resolución completa, 1 la mitad y 2 un cuarto
+    const cv::Mat& luma(int nivel) const { return nivel == 0 ? y : piramide[nivel - 1]; }
+};
+
+// Nivel más reducido de la pirámide de luma
+const int nivelMaximoPiramide = 2;
+
+// Función que construye la pirámide de luma hasta `niveles` (0 a nivelMaximoPiramide)
+// una sola vez por frame: cada nivel se filtra y reduce a la mitad desde el anterior con
+// pyrDown, así que todas las ramas que trabajan a baja resolución lo comparten
+inline void construirPiramide(FrameLuma& frame, int niveles, PoolBuffers& pool) {
+    for (int nivel = 1; nivel <= niveles; nivel++) {
+        const cv::Mat& anterior = frame.luma(nivel - 1);
+        cv::Mat& reducida = frame.piramide[nivel - 1];
+        reducida = pool.obtener(cv::Size((anterior.cols + 1) / 2, (anterior.rows + 1) / 2), CV_8UC1);
+        cv::pyrDown(anterior, reducida, reducida.size());
+    }
+}
+
+// Y, Cr y Cb de un frame BGR con la misma aritmética de punto fijo (14 bits) que
+// cvtColor con COLOR_BGR2YCrCb, como tres expresiones por píxel de un mismo recorrido
+inline auto asignacionesLumaCroma(const cv::Mat& color, cv::Mat& y, cv::Mat& cr, cv::Mat& cb) {
+    const int redondeo = 1 << 13, medio = 128 << 14;
+    auto b = pixel::leerCanal<uchar, 3>(color, 0);
+    auto g = pixel::leerCanal<uchar, 3>(color, 1);
+    auto r = pixel::leerCanal<uchar, 3>(color, 2);
+    auto luma = (b * 1868 + g * 9617 + r * 4899 + redondeo) >> 14;
+    return std::make_tuple(pixel::asignar(y, luma), pixel::asignar(cr, ((r - luma) * 11682 + medio + redondeo) >> 14),
+                           pixel::asignar(cb, ((b - luma) * 9241 + medio + redondeo) >> 14));
+}
+
+// Función que extrae luma y croma de un frame BGR en una sola pasada: escribe
+// directamente los tres planos, sin la imagen intercalada ni el split
+inline void extraerLuma(const cv::Mat& color, FrameLuma& frame, PoolBuffers& pool) {
+    CV_Assert(color.type() == CV_8UC3);
+    cv::Mat planos[3];
+    for (cv::Mat& plano : planos) plano = pool.obtener(color.size(), CV_8UC1);
+    pixel::evaluar(asignacionesLumaCroma(color, planos[0], planos[1], planos[2]));
+    frame.color = color;
+    frame.y = planos[0];
+    frame.cr = planos[1];
+    frame.cb = planos[2];
+}
+
+// Función que recompone el BGR a partir de una luma realzada y la croma original
+inline void reconstruirBGR(const FrameLuma& frame, const cv::Mat& luma, cv::Mat& color, PoolBuffers& pool) {
+    cv::Mat planos[3] = {luma, frame.cr, frame.cb};
+    cv::Mat ycrcb = pool.obtener(luma.size(), CV_8UC3);
+    cv::merge(planos, 3, ycrcb);
+    cv::cvtColor(ycrcb, color, cv::COLOR_YCrCb2BGR);
+}
+
+// Función que aplica ecualización de histograma sobre la luma
+inline void aplicarEcualizacionHistograma(const cv::Mat& luma, cv::Mat& resultado) {
+    cv::equalizeHist(luma, resultado);
+}
+
+// Función que aplica el filtro CLAHE sobre la luma
+inline void aplicarCLAHE(cv::CLAHE& clahe, const cv::Mat& luma, cv::Mat& resultado) {
+    clahe.apply(luma, resultado);
+}
+
+// Función que calcula la tabla de corrección gamma
+inline void calcularTablaGamma(double gamma, cv::Mat& tablaLUT) {
+    tablaLUT.create(1, 256, CV_8U);
+    uchar* p = tablaLUT.ptr();
+    for (int i = 0; i < 256; ++i)
+        p[i] = cv::saturate_cast<uchar>(std::pow(i / 255.0, gamma) * 255.0);
+}
+
+// Función que aplica la corrección gamma (sobre luma o sobre BGR)
+inline void aplicarCorreccionGamma(const cv::Mat& imagen, const cv::Mat& tablaLUT, cv::Mat& resultado) {
+    cv::LUT(imagen, tablaLUT, resultado);
+}
+
+enum class FiltroRealce { Ninguno, Ecualizacion, CLAHE, Gamma };
+
+// Motor de realce de una rama: trabaja sobre la luma ya extraída y conserva su
+// estado entre frames (objeto CLAHE, tabla gamma) en lugar de recrearlo
+class MotorRealce {
+public:
+    explicit MotorRealce(FiltroRealce filtro) : filtro_(filtro) {
+        if (filtro_ == FiltroRealce::CLAHE) {
+            clahe_ = cv::createCLAHE();
+            clahe_->setClipLimit(4);
+            // Objeto propio para realzarLuma: alternar dos tamaños en el mismo objeto
+            // volvería a reservar sus buffers internos en cada llamada
+            claheLuma_ = cv::createCLAHE();
+            claheLuma_->setClipLimit(4);
+        }
+    }
+
+    // Genera la luma realzada (la imagen gris del movimiento) y el BGR a mostrar; cada
+    // salida es opcional. Sin `luma` (el movimiento va en otro nivel de la pirámide) la
+    // luma completa solo se calcula si hace falta para reconstruir el color.
+    // Las salidas salen del pool de la rama, salvo en la rama original que comparte el frame,
+    // o van al destino de color que pase el llamador si ya tiene el tamaño del frame.
+    void procesar(const FrameLuma& frame, double gamma, PoolBuffers& pool, cv::Mat* luma, cv::Mat* color) {
+        bool yuv = !frame.i420.empty();
+        if (filtro_ == FiltroRealce::Ninguno) {
+            if (luma) *luma = frame.y;
+            if (color && yuv) {
+                prepararColor(frame, *color, pool);
+                cv::cvtColor(frame.i420, *color, cv::COLOR_YUV2BGR_I420);
+            } else if (color && destinoValido(frame, *color)) {
+                frame.color.copyTo(*color);
+            } else if (color) {
+                *color = frame.color;
+            }
+            return;
+        }
+
+        // La corrección gamma de una entrada BGR se aplica sobre el BGR: la luma completa
+        // no interviene en el color
+        const bool gammaBGR = filtro_ == FiltroRealce::Gamma && !yuv;
+        if (!luma && (!color || gammaBGR)) {
+            if (color) {
+                prepararColor(frame, *color, pool);
+                actualizarTablaGamma(gamma);
+                aplicarCorreccionGamma(frame.color, tablaGamma_, *color);
+            }
+            return;
+        }
+
+        // Con entrada YUV la luma realzada se escribe directamente en las filas Y de
+        // un buffer I420 propio, así reconstruir el color solo requiere copiar la croma
+        cv::Mat i420, realzada;
+        if (yuv) {
+            i420 = pool.obtenerComo(frame.i420);
+            realzada = i420.rowRange(0, frame.y.rows);
+        } else {
+            realzada = pool.obtenerComo(frame.y);
+        }
+        if (color) prepararColor(frame, *color, pool);
+
+        switch (filtro_) {
+        case FiltroRealce::Ninguno:
+            break;
+        case FiltroRealce::Ecualizacion:
+            aplicarEcualizacionHistograma(frame.y, realzada);
+            if (color) reconstruir(frame, realzada, i420, *color, pool);
+            break;
+        case FiltroRealce::CLAHE:
+            aplicarCLAHE(*clahe_, frame.y, realzada);
+            if (color) reconstruir(frame, realzada, i420, *color, pool);
+            break;
+        case FiltroRealce::Gamma:
+            actualizarTablaGamma(gamma);
+            aplicarCorreccionGamma(frame.y, tablaGamma_, realzada);
+            if (color && yuv) reconstruir(frame, realzada, i420, *color, pool);
+            else if (color) aplicarCorreccionGamma(frame.color, tablaGamma_, *color);
+            break;
+        }
+        if (luma) *luma = realzada;
+    }
+
+    // Aplica el filtro solo a una luma suelta, por ejemplo un nivel reducido de la
+    // pirámide para la detección de movimiento; no toca el color
+    void realzarLuma(const cv::Mat& y, double gamma, PoolBuffers& pool, cv::Mat& luma) {
+        if (filtro_ == FiltroRealce::Ninguno) {
+            luma = y;
+            return;
+        }
+        luma = pool.obtenerComo(y);
+        switch (filtro_) {
+        case FiltroRealce::Ninguno:
+            break;
+        case FiltroRealce::Ecualizacion:
+            aplicarEcualizacionHistograma(y, luma);
+            break;
+        case FiltroRealce::CLAHE:
+            aplicarCLAHE(*claheLuma_, y, luma);
+            break;
+        case FiltroRealce::Gamma:
+            actualizarTablaGamma(gamma);
+            aplicarCorreccionGamma(y, tablaGamma_, luma);
+            break;
+        }
+    }
+
+private:
+    // La tabla solo se recalcula cuando cambia el trackbar
+    void actualizarTablaGamma(double gamma) {
+        if (gamma != gammaTabla_) {
+            calcularTablaGamma(gamma, tablaGamma_);
+            gammaTabla_ = gamma;
+        }
+    }
+
+    // El llamador puede pasar en `color` un destino ya reservado (por ejemplo, un panel
+    // del mosaico de salida); si tiene el tamaño y tipo del frame se escribe ahí
+    static bool destinoValido(const FrameLuma& frame, const cv::Mat& color) {
+        return color.size() == frame.y.size() && color.type() == CV_8UC3;
+    }
+
+    static void prepararColor(const FrameLuma& frame, cv::Mat& color, PoolBuffers& pool) {
+        if (!destinoValido(frame, color)) color = pool.obtener(frame.y.size(), CV_8UC3);
+    }
+
+    // Recompone el BGR desde la luma realzada; con entrada YUV es el único punto que toca la croma
+    static void reconstruir(const FrameLuma& frame, const cv::Mat& luma, cv::Mat& i420, cv::Mat& color, PoolBuffers& pool) {
+        if (i420.empty()) {
+            reconstruirBGR(frame, luma, color, pool);
+            return;
+        }
+        int filas = frame.y.rows;
+        frame.i420.rowRange(filas, frame.i420.rows).copyTo(i420.rowRange(filas, i420.rows));
+        cv::cvtColor(i420, color, cv::COLOR_YUV2BGR_I420);
+    }
+
+    FiltroRealce filtro_;
+    cv::Ptr<cv::CLAHE> clahe_, claheLuma_;
+    cv::Mat tablaGamma_;
+    double gammaTabla_ = -1.0;
+};
+
+#endif
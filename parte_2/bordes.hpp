@@ -0,0 +1,42 @@
+#ifndef BORDES_HPP
+#define BORDES_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include "pixel.hpp"
+#include "pool_buffers.hpp"
+
+// Magnitud Sobel a partir de los gradientes: equivale a convertScaleAbs en cada
+// gradiente seguido de addWeighted(0.5, 0.5), redondeando al par como OpenCV,
+// pero en una sola pasada paralela y sin imágenes intermedias.
+inline auto expresionMagnitudSobel(const cv::Mat &grad_x, const cv::Mat &grad_y) {
+    auto ax = pixel::saturar(pixel::absoluto(pixel::leer<short>(grad_x)));
+    auto ay = pixel::saturar(pixel::absoluto(pixel::leer<short>(grad_y)));
+    auto suma = ax + ay;
+    return (suma >> 1) + (suma & (suma >> 1) & 1);
+}
+
+inline void magnitudSobel(const cv::Mat &grad_x, const cv::Mat &grad_y, cv::Mat &magnitud) {
+    pixel::evaluar(expresionMagnitudSobel(grad_x, grad_y), magnitud);
+}
+
+// Función para detección de bordes Canny y Sobel con gradientes compartidos: una
+// conversión a gris y un par de Sobel por imagen. Los gradientes usan BORDER_REPLICATE,
+// el borde del Sobel 3x3 interno de Canny, así que Canny sale idéntico a llamarlo sobre
+// el gris. La magnitud Sobel difiere del borde por defecto (reflejo 101) solo en la
+// franja de un píxel del contorno de la imagen. Los resultados son de un canal.
+inline void deteccionBordesCannySobel(const cv::Mat &imagen, cv::Mat &bordes_canny, cv::Mat &bordes_sobel, PoolBuffers &pool) {
+    cv::Mat imagen_gris = pool.obtener(imagen.size(), CV_8UC1);
+    cv::Mat grad_x = pool.obtener(imagen.size(), CV_16SC1), grad_y = pool.obtener(imagen.size(), CV_16SC1);
+
+    cv::cvtColor(imagen, imagen_gris, cv::COLOR_BGR2GRAY);
+    cv::Sobel(imagen_gris, grad_x, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::Sobel(imagen_gris, grad_y, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+
+    cv::Canny(grad_x, grad_y, bordes_canny, 50, 150);
+    magnitudSobel(grad_x, grad_y, bordes_sobel);
+}
+
+#endif
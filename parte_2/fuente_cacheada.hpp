@@ -0,0 +1,79 @@
+#ifndef FUENTE_CACHEADA_HPP
+#define FUENTE_CACHEADA_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <cstddef>
+#include <vector>
+
+// Fuente de un video que se reproduce en bucle. La primera vuelta decodifica y
+// redimensiona cada frame una sola vez y lo guarda en un anillo en memoria; las
+// vueltas siguientes recorren el anillo sin decodificar ni volver al inicio del
+// archivo con CAP_PROP_POS_FRAMES. Si el clip redimensionado supera el límite de
+// bytes, el anillo se libera y la fuente sigue decodificando y buscando como antes.
+class FuenteVideoCacheada {
+public:
+    // limiteBytes = 0 desactiva el anillo: siempre decodifica
+    FuenteVideoCacheada(cv::VideoCapture& captura, cv::Size tamano, size_t limiteBytes)
+        : captura_(captura), tamano_(tamano), limiteBytes_(limiteBytes), cacheando_(limiteBytes > 0) {}
+
+    // Entrega el siguiente frame ya redimensionado. Es una vista sobre el anillo o
+    // sobre el buffer de la fuente: el llamador no debe escribir en él.
+    bool leer(cv::Mat& frame) {
+        if (completa_) {
+            frame = anillo_[siguiente_];
+            siguiente_ = (siguiente_ + 1) % anillo_.size();
+            return true;
+        }
+
+        captura_ >> decodificado_;
+        if (decodificado_.empty()) {
+            if (cacheando_ && !anillo_.empty()) {
+                // Terminó la primera vuelta con todo el clip en el anillo
+                completa_ = true;
+                captura_.release();
+                return leer(frame);
+            }
+            captura_.set(cv::CAP_PROP_POS_FRAMES, 0); // Reiniciar el video si llega al final
+            captura_ >> decodificado_;
+            if (decodificado_.empty()) return false;
+        }
+
+        if (cacheando_) {
+            size_t bytesFrame = size_t(tamano_.area()) * decodificado_.elemSize();
+            if (bytesAnillo() + bytesFrame <= limiteBytes_) {
+                // Un buffer propio por frame: el anillo conserva todos los de la primera vuelta
+                anillo_.emplace_back();
+                cv::resize(decodificado_, anillo_.back(), tamano_);
+                frame = anillo_.back();
+                return true;
+            }
+            // El clip no cabe: se descarta el anillo y se sigue decodificando
+            cacheando_ = false;
+            anillo_.clear();
+            anillo_.shrink_to_fit();
+        }
+
+        cv::resize(decodificado_, redimensionado_, tamano_); // Reutiliza el buffer si nadie más lo retiene
+        frame = redimensionado_;
+        return true;
+    }
+
+    // Indica si las lecturas ya salen del anillo, sin decodificar
+    bool completa() const { return completa_; }
+    size_t frames() const { return anillo_.size(); }
+    size_t bytesAnillo() const { return anillo_.empty() ? 0 : anillo_.size() * anillo_.front().total() * anillo_.front().elemSize(); }
+
+private:
+    cv::VideoCapture& captura_;
+    cv::Size tamano_;
+    size_t limiteBytes_;
+    bool cacheando_;
+    bool completa_ = false;
+    std::vector<cv::Mat> anillo_;
+    size_t siguiente_ = 0;
+    cv::Mat decodificado_, redimensionado_;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef GRAFO_HPP
+#define GRAFO_HPP
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Nodo de un grafo de procesamiento con caché. Guarda la versión de cada
+// entrada y la clave de sus parámetros con las que calculó su salida; solo
+// vuelve a calcular si alguna de ellas cambió. Las salidas viven fuera del nodo
+// (en las variables que modifica `calcular`), así que persisten entre pasadas.
+class NodoGrafo {
+public:
+    NodoGrafo(std::vector<NodoGrafo*> entradas, std::function<long()> clave, std::function<void()> calcular)
+        : entradas_(std::move(entradas)), versionesEntradas_(entradas_.size(), 0),
+          clave_(std::move(clave)), calcular_(std::move(calcular)) {}
+
+    // Pone al día la salida del nodo (y antes la de sus entradas) y devuelve su versión.
+    // En una misma pasada cada nodo se evalúa una sola vez aunque varios dependan de él.
+    unsigned long actualizar(unsigned long pasada) {
+        if (pasada == ultimaPasada_) return version_;
+        ultimaPasada_ = pasada;
+
+        bool cambio = version_ == 0;
+        for (size_t i = 0; i < entradas_.size(); i++) {
+            unsigned long version = entradas_[i]->actualizar(pasada);
+            if (version != versionesEntradas_[i]) {
+                versionesEntradas_[i] = version;
+                cambio = true;
+            }
+        }
+        if (clave_) {
+            long clave = clave_();
+            if (clave != claveAnterior_) {
+                claveAnterior_ = clave;
+                cambio = true;
+            }
+        }
+
+        if (cambio) {
+            calcular_();
+            version_++;
+        }
+        return version_;
+    }
+
+private:
+    std::vector<NodoGrafo*> entradas_;
+    std::vector<unsigned long> versionesEntradas_;
+    std::function<long()> clave_;
+    std::function<void()> calcular_;
+    long claveAnterior_ = 0;
+    unsigned long version_ = 0;
+    unsigned long ultimaPasada_ = 0;
+};
+
+#endif
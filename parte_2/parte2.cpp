@@ -1,84 +1,195 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
-#include <random>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "pool_buffers.hpp"
+#include "ruido.hpp"
+#include "grafo.hpp"
+#include "bordes.hpp"
+#include "suavizado.hpp"
+#include "mosaico.hpp"
+#include "salida.hpp"
+#include "fuente_cacheada.hpp"
 
 using namespace cv;
 using namespace std;
 
-// Función para agregar ruido de sal y pimienta a una imagen
-void agregarRuidoSalPimienta(Mat &imagen, float prob_sal, float prob_pimienta) {
-    RNG rng;
-    for (int i = 0; i < imagen.rows; i++) {
-        for (int j = 0; j < imagen.cols; j++) {
-            float valor_aleatorio = rng.uniform(0.0f, 1.0f);
-            if (valor_aleatorio < prob_sal) {
-                imagen.at<Vec3b>(i, j) = Vec3b(255, 255, 255); // Sal (blanco)
-            } else if (valor_aleatorio < prob_sal + prob_pimienta) {
-                imagen.at<Vec3b>(i, j) = Vec3b(0, 0, 0); // Pimienta (negro)
-            }
-        }
-    }
-}
-
 // Variables globales para los trackbars
 int deslizador_sal = 0; // Deslizador para la probabilidad de sal
 int deslizador_pimienta = 0; // Deslizador para la probabilidad de pimienta
 int deslizador_tamano_mascara = 1; // Deslizador para el tamaño de la máscara de los filtros
 Mat imagen_original, imagen_con_ruido;
 Size tamano_nuevo(400, 240); // Tamaño nuevo para redimensionar el video
-
-// Función callback para los trackbars
-void on_trackbar(int, void*) {
-    imagen_con_ruido = imagen_original.clone();
-    float prob_sal = deslizador_sal / 100.0;
-    float prob_pimienta = deslizador_pimienta / 100.0;
-    agregarRuidoSalPimienta(imagen_con_ruido, prob_sal, prob_pimienta);
-    imshow("Video con Ruido", imagen_con_ruido);
-}
+PoolBuffers pool; // Buffers reutilizados por todas las etapas entre fotogramas
+uint32_t semilla_ruido = 0; // Semilla base del ruido (--semilla=N); cada fotograma usa semilla + número de fotograma
+uint32_t numero_fotograma = 0;
+unique_ptr<SalidaFrames> salida; // Ventanas o escritura asíncrona a archivos (--salida); los mosaicos se reutilizan, así que se envían con copia
 
 // Función para aplicar filtros de suavizado y devolver los resultados
 void aplicarFiltros(const Mat &imagen, Mat &filtrado_mediana, Mat &filtrado_blur, Mat &filtrado_gaussiano) {
     int tamano_mascara = deslizador_tamano_mascara * 2 + 1; // Tamaño de la máscara (debe ser impar)
-    
-    // Aplicar filtro de mediana
-    medianBlur(imagen, filtrado_mediana, tamano_mascara);
-    // Aplicar filtro de blur (promedio)
-    blur(imagen, filtrado_blur, Size(tamano_mascara, tamano_mascara));
-    // Aplicar filtro Gaussiano
-    GaussianBlur(imagen, filtrado_gaussiano, Size(tamano_mascara, tamano_mascara), 1.5);
+
+    // Mediana, blur (promedio) y Gaussiano
+    aplicarFiltrosSuavizado(imagen, tamano_mascara, filtrado_mediana, filtrado_blur, filtrado_gaussiano);
+}
+
+// Función que mide el banco de suavizado para cada tamaño de máscara del deslizador
+void medirSuavizado(const Mat &imagen) {
+    const int repeticiones = 30;
+    Mat mediana, blur, gaussiano;
+    cout << "mascara\tms\thilos=" << getNumThreads() << endl;
+    for (int deslizador = 0; deslizador <= 10; deslizador++) {
+        int tamano_mascara = deslizador * 2 + 1;
+        int64 inicio = getTickCount();
+        for (int r = 0; r < repeticiones; r++)
+            aplicarFiltrosSuavizado(imagen, tamano_mascara, mediana, blur, gaussiano);
+        double milisegundos = (getTickCount() - inicio) * 1000.0 / getTickFrequency() / repeticiones;
+        cout << tamano_mascara << "x" << tamano_mascara << "\t" << milisegundos << endl;
+    }
 }
 
-// Función para detección de bordes usando Canny
-void deteccionBordes(const Mat &imagen, Mat &bordes) {
-    Mat imagen_gris;
-    cvtColor(imagen, imagen_gris, COLOR_BGR2GRAY);
-    Canny(imagen_gris, bordes, 50, 150);
-    cvtColor(bordes, bordes, COLOR_GRAY2BGR); // Convertir a BGR para que coincida el tipo
+// Mosaicos 2x2 de cada ventana. Las etapas escriben directamente en sus paneles,
+// así que las salidas filtrado_* y bordes_* son vistas de los lienzos. Los bordes
+// se muestran en un canal: no hace falta expandirlos a BGR.
+Mosaico mosaico_filtrado(2, 2), mosaico_canny(2, 2, CV_8UC1), mosaico_sobel(2, 2, CV_8UC1);
+const string textos_filtrado[4] = {"Mediana", "Blur", "Gaussiano", "Original"};
+const string textos_bordes[4] = {"Bordes Mediana", "Bordes Blur", "Bordes Gaussiano", "Bordes Original"};
+
+// Estampa las etiquetas (rasterizadas una sola vez) en los paneles de un mosaico
+void etiquetarMosaico(Mosaico &mosaico, const string textos[4]) {
+    for (int i = 0; i < 4; i++) mosaico.etiquetar(i, textos[i], Point(10, 30));
 }
 
-// Función para detección de bordes usando el algoritmo Sobel
-void deteccionBordesSobel(const Mat &imagen, Mat &bordes) {
-    Mat imagen_gris, grad_x, grad_y;
-    Mat abs_grad_x, abs_grad_y;
-
-    cvtColor(imagen, imagen_gris, COLOR_BGR2GRAY);
-    
-    Sobel(imagen_gris, grad_x, CV_16S, 1, 0, 3, 1, 0, BORDER_DEFAULT);
-    Sobel(imagen_gris, grad_y, CV_16S, 0, 1, 3, 1, 0, BORDER_DEFAULT);
-    
-    convertScaleAbs(grad_x, abs_grad_x);
-    convertScaleAbs(grad_y, abs_grad_y);
-    
-    addWeighted(abs_grad_x, 0.5, abs_grad_y, 0.5, 0, bordes);
-    cvtColor(bordes, bordes, COLOR_GRAY2BGR); // Convertir a BGR para que coincida el tipo
+// Salidas de cada etapa: vistas de los paneles, persisten entre fotogramas para que el grafo pueda reutilizarlas
+Mat filtrado_mediana, filtrado_blur, filtrado_gaussiano;
+Mat bordes_mediana, bordes_blur, bordes_gaussiano, bordes_original;
+Mat bordes_mediana_sobel, bordes_blur_sobel, bordes_gaussiano_sobel, bordes_original_sobel;
+
+// Grafo de procesamiento: cada nodo se recalcula solo si cambió el fotograma o sus
+// deslizadores. Con el video en pausa y sin tocar nada, ningún nodo se ejecuta.
+NodoGrafo nodo_fotograma({}, [] { return long(numero_fotograma); }, [] {});
+
+NodoGrafo nodo_ruido({&nodo_fotograma}, [] { return long(deslizador_sal) * 1000 + deslizador_pimienta; }, [] {
+    imagen_original.copyTo(imagen_con_ruido); // Reutiliza el buffer de imagen_con_ruido
+    float prob_sal = deslizador_sal / 100.0;
+    float prob_pimienta = deslizador_pimienta / 100.0;
+    agregarRuidoSalPimienta(imagen_con_ruido, prob_sal, prob_pimienta, semilla_ruido + numero_fotograma);
+});
+
+// Los filtros escriben en los paneles del mosaico; el panel "Original" es la única copia,
+// porque la ventana de ruido muestra la misma imagen sin etiqueta
+NodoGrafo nodo_filtros({&nodo_ruido}, [] { return long(deslizador_tamano_mascara); }, [] {
+    mosaico_filtrado.preparar(imagen_con_ruido.size());
+    filtrado_mediana = mosaico_filtrado.panel(0);
+    filtrado_blur = mosaico_filtrado.panel(1);
+    filtrado_gaussiano = mosaico_filtrado.panel(2);
+    aplicarFiltros(imagen_con_ruido, filtrado_mediana, filtrado_blur, filtrado_gaussiano);
+    mosaico_filtrado.colocar(3, imagen_con_ruido);
+});
+
+// Detectar bordes Canny y Sobel en las imágenes filtradas y en la imagen con ruido,
+// escribiendo cada resultado en su panel
+NodoGrafo nodo_bordes({&nodo_filtros, &nodo_ruido}, nullptr, [] {
+    mosaico_canny.preparar(imagen_con_ruido.size());
+    mosaico_sobel.preparar(imagen_con_ruido.size());
+    Mat *canny[4] = {&bordes_mediana, &bordes_blur, &bordes_gaussiano, &bordes_original};
+    Mat *sobel[4] = {&bordes_mediana_sobel, &bordes_blur_sobel, &bordes_gaussiano_sobel, &bordes_original_sobel};
+    for (int i = 0; i < 4; i++) {
+        *canny[i] = mosaico_canny.panel(i);
+        *sobel[i] = mosaico_sobel.panel(i);
+    }
+    deteccionBordesCannySobel(filtrado_mediana, bordes_mediana, bordes_mediana_sobel, pool);
+    deteccionBordesCannySobel(filtrado_blur, bordes_blur, bordes_blur_sobel, pool);
+    deteccionBordesCannySobel(filtrado_gaussiano, bordes_gaussiano, bordes_gaussiano_sobel, pool);
+    deteccionBordesCannySobel(imagen_con_ruido, bordes_original, bordes_original_sobel, pool);
+});
+
+// Mostrar cada ventana solo cuando cambió su contenido
+NodoGrafo nodo_ventana_ruido({&nodo_ruido}, nullptr, [] { salida->enviarCopia("Video con Ruido", imagen_con_ruido); });
+
+// Depende también de los bordes: las etiquetas se estampan sobre los paneles filtrados
+// solo después de que la detección de bordes los leyó
+NodoGrafo nodo_ventana_filtrado({&nodo_filtros, &nodo_bordes}, nullptr, [] {
+    etiquetarMosaico(mosaico_filtrado, textos_filtrado);
+    salida->enviarCopia("Video Filtrado", mosaico_filtrado.lienzo());
+});
+
+NodoGrafo nodo_ventana_canny({&nodo_bordes}, nullptr, [] {
+    etiquetarMosaico(mosaico_canny, textos_bordes);
+    salida->enviarCopia("Deteccion de Bordes Canny", mosaico_canny.lienzo());
+});
+
+NodoGrafo nodo_ventana_sobel({&nodo_bordes}, nullptr, [] {
+    etiquetarMosaico(mosaico_sobel, textos_bordes);
+    salida->enviarCopia("Deteccion de Bordes Sobel", mosaico_sobel.lienzo());
+});
+
+// Evalúa el grafo a partir de las ventanas: solo se ejecuta lo que quedó desactualizado
+void procesar() {
+    static unsigned long pasada = 0;
+    if (imagen_original.empty()) return; // Todavía no se leyó ningún fotograma
+    pasada++;
+    nodo_ventana_ruido.actualizar(pasada);
+    nodo_ventana_filtrado.actualizar(pasada);
+    nodo_ventana_canny.actualizar(pasada);
+    nodo_ventana_sobel.actualizar(pasada);
 }
 
-// Función para agregar texto a una imagen
-void agregarTexto(Mat &imagen, const string &texto, const Point &posicion) {
-    putText(imagen, texto, posicion, FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 255, 255), 2);
+// Función callback para los trackbars: responde al instante aunque el video esté en pausa
+void on_trackbar(int, void*) {
+    procesar();
 }
 
 int main(int argc, char** argv) {
+    // Uso: parte2 [--semilla=N] [--medir-suavizado] [--salida=ventana|video:DIR|mjpeg:DIR|png:DIR]
+    //             [--espera=MS] [--fotogramas=N] [--cache-mb=N] [--sal=0..100] [--pimienta=0..100]
+    //             [--mascara=1..21]
+    // --espera es la pausa entre fotogramas (23 ms por defecto; 0 procesa a toda velocidad).
+    // Sin ventanas el programa termina tras --fotogramas fotogramas o con SIGINT/SIGTERM.
+    // --sal, --pimienta (porcentajes) y --mascara (tamaño impar) dan el valor inicial de los
+    // deslizadores; sin ventanas son la única forma de elegir el ruido y la máscara.
+    // --cache-mb es el límite del anillo de frames ya redimensionados con el que se repite
+    // el video (256 MB por defecto; 0 decodifica en cada vuelta).
+    AsignadorContador& asignador = AsignadorContador::instalar(); // Cuenta las reservas reales de Mat
+    bool medir_suavizado = false;
+    string especificacion_salida = "ventana";
+    int espera = 23;
+    long limite_fotogramas = 0;
+    size_t limite_cache_mb = 256;
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento.rfind("--semilla=", 0) == 0) {
+            semilla_ruido = uint32_t(strtoul(argumento.c_str() + 10, nullptr, 10));
+        } else if (argumento == "--medir-suavizado") {
+            medir_suavizado = true;
+        } else if (argumento.rfind("--salida=", 0) == 0) {
+            especificacion_salida = argumento.substr(9);
+        } else if (argumento.rfind("--espera=", 0) == 0) {
+            espera = max(0, atoi(argumento.c_str() + 9));
+        } else if (argumento.rfind("--fotogramas=", 0) == 0) {
+            limite_fotogramas = atol(argumento.c_str() + 13);
+        } else if (argumento.rfind("--cache-mb=", 0) == 0) {
+            limite_cache_mb = size_t(max(0L, atol(argumento.c_str() + 11)));
+        } else if (argumento.rfind("--sal=", 0) == 0) {
+            deslizador_sal = min(100, max(0, atoi(argumento.c_str() + 6)));
+        } else if (argumento.rfind("--pimienta=", 0) == 0) {
+            deslizador_pimienta = min(100, max(0, atoi(argumento.c_str() + 11)));
+        } else if (argumento.rfind("--mascara=", 0) == 0) {
+            int tamano_mascara = atoi(argumento.c_str() + 10);
+            if (tamano_mascara < 1 || tamano_mascara > 21 || tamano_mascara % 2 == 0) {
+                cout << "Tamaño de máscara no válido (impar de 1 a 21): " << argumento << endl;
+                return -1;
+            }
+            deslizador_tamano_mascara = tamano_mascara / 2;
+        } else {
+            cout << "Argumento desconocido: " << argumento << endl;
+            return -1;
+        }
+    }
+
     // Cargar el video desde el archivo
     VideoCapture cap("video.mp4");
     if (!cap.isOpened()) {
@@ -86,114 +197,83 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    // Crear ventanas y trackbars
-    namedWindow("Video con Ruido", 1);
-    createTrackbar("Sal", "Video con Ruido", &deslizador_sal, 100, on_trackbar);
-    createTrackbar("Pimienta", "Video con Ruido", &deslizador_pimienta, 100, on_trackbar);
-    createTrackbar("Tamano de la Mascara", "Video con Ruido", &deslizador_tamano_mascara, 10, on_trackbar);
-
-    namedWindow("Deteccion de Bordes Canny", 1);
-    namedWindow("Deteccion de Bordes Sobel", 1);
-
-    while (true) {
-        cap >> imagen_original; // Capturar un fotograma del video
-        if (imagen_original.empty()) {
-            cap.set(CAP_PROP_POS_FRAMES, 0); // Reiniciar el video si llega al final
-            cap >> imagen_original;
-            if (imagen_original.empty()) break; // Salir si no se puede capturar un fotograma
+    // Modo de medición: primer fotograma con 10% de ruido, sin ventanas
+    if (medir_suavizado) {
+        Mat frame;
+        cap >> frame;
+        if (frame.empty()) {
+            cout << "Error al leer el video" << endl;
+            return -1;
         }
+        resize(frame, imagen_original, tamano_nuevo);
+        imagen_original.copyTo(imagen_con_ruido);
+        agregarRuidoSalPimienta(imagen_con_ruido, 0.05f, 0.05f, semilla_ruido);
+        medirSuavizado(imagen_con_ruido);
+        return 0;
+    }
 
-        resize(imagen_original, imagen_original, tamano_nuevo); // Redimensionar el fotograma
-
-        on_trackbar(0, 0); // Aplicar ruido de sal y pimienta
-
-        // Aplicar filtros de suavizado
-        Mat filtrado_mediana, filtrado_blur, filtrado_gaussiano;
-        aplicarFiltros(imagen_con_ruido, filtrado_mediana, filtrado_blur, filtrado_gaussiano);
-
-        // Detectar bordes en las imágenes filtradas usando Canny
-        Mat bordes_mediana, bordes_blur, bordes_gaussiano;
-        deteccionBordes(filtrado_mediana, bordes_mediana);
-        deteccionBordes(filtrado_blur, bordes_blur);
-        deteccionBordes(filtrado_gaussiano, bordes_gaussiano);
-
-        // Detectar bordes en las imágenes filtradas usando Sobel
-        Mat bordes_mediana_sobel, bordes_blur_sobel, bordes_gaussiano_sobel;
-        deteccionBordesSobel(filtrado_mediana, bordes_mediana_sobel);
-        deteccionBordesSobel(filtrado_blur, bordes_blur_sobel);
-        deteccionBordesSobel(filtrado_gaussiano, bordes_gaussiano_sobel);
-
-        // Crear una imagen grande para mostrar todas las imágenes filtradas y sus bordes (Canny)
-        Mat resultado_filtrado(Size(imagen_con_ruido.cols * 2, imagen_con_ruido.rows * 2), imagen_con_ruido.type());
-        Mat resultado_bordes_canny(Size(imagen_con_ruido.cols * 2, imagen_con_ruido.rows * 2), imagen_con_ruido.type());
-
-        // Copiar las imágenes filtradas a la imagen de resultado y agregar texto (Canny)
-        filtrado_mediana.copyTo(resultado_filtrado(Rect(0, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado, "Mediana", Point(10, 30));
-
-        filtrado_blur.copyTo(resultado_filtrado(Rect(imagen_con_ruido.cols, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado, "Blur", Point(imagen_con_ruido.cols + 10, 30));
-
-        filtrado_gaussiano.copyTo(resultado_filtrado(Rect(0, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado, "Gaussiano", Point(10, imagen_con_ruido.rows + 30));
-
-        imagen_con_ruido.copyTo(resultado_filtrado(Rect(imagen_con_ruido.cols, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado, "Original", Point(imagen_con_ruido.cols + 10, imagen_con_ruido.rows + 30));
-
-        // Copiar las imágenes de bordes a la imagen de resultado y agregar texto (Canny)
-        bordes_mediana.copyTo(resultado_bordes_canny(Rect(0, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_canny, "Bordes Mediana", Point(10, 30));
-
-        bordes_blur.copyTo(resultado_bordes_canny(Rect(imagen_con_ruido.cols, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_canny, "Bordes Blur", Point(imagen_con_ruido.cols + 10, 30));
-
-        bordes_gaussiano.copyTo(resultado_bordes_canny(Rect(0, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_canny, "Bordes Gaussiano", Point(10, imagen_con_ruido.rows + 30));
-
-        deteccionBordes(imagen_con_ruido, imagen_con_ruido); // Detectar bordes en la imagen con ruido
-        imagen_con_ruido.copyTo(resultado_bordes_canny(Rect(imagen_con_ruido.cols, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_canny, "Bordes Original", Point(imagen_con_ruido.cols + 10, imagen_con_ruido.rows + 30));
-
-        // Crear una imagen grande para mostrar todas las imágenes filtradas y sus bordes (Sobel)
-        Mat resultado_filtrado_sobel(Size(imagen_con_ruido.cols * 2, imagen_con_ruido.rows * 2), imagen_con_ruido.type());
-        Mat resultado_bordes_sobel(Size(imagen_con_ruido.cols * 2, imagen_con_ruido.rows * 2), imagen_con_ruido.type());
-
-        // Copiar las imágenes filtradas a la imagen de resultado y agregar texto (Sobel)
-        filtrado_mediana.copyTo(resultado_filtrado_sobel(Rect(0, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado_sobel, "Mediana", Point(10, 30));
-
-        filtrado_blur.copyTo(resultado_filtrado_sobel(Rect(imagen_con_ruido.cols, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado_sobel, "Blur", Point(imagen_con_ruido.cols + 10, 30));
-
-        filtrado_gaussiano.copyTo(resultado_filtrado_sobel(Rect(0, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado_sobel, "Gaussiano", Point(10, imagen_con_ruido.rows + 30));
-
-        imagen_con_ruido.copyTo(resultado_filtrado_sobel(Rect(imagen_con_ruido.cols, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_filtrado_sobel, "Original", Point(imagen_con_ruido.cols + 10, imagen_con_ruido.rows + 30));
+    try {
+        salida = crearSalida(especificacion_salida, cap.get(CAP_PROP_FPS));
+    } catch (const exception& error) {
+        cout << error.what() << endl;
+        return -1;
+    }
 
-        // Copiar las imágenes de bordes a la imagen de resultado y agregar texto (Sobel)
-        bordes_mediana_sobel.copyTo(resultado_bordes_sobel(Rect(0, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_sobel, "Bordes Mediana", Point(10, 30));
+    // Crear ventanas y trackbars (sin ventanas los deslizadores quedan en sus valores iniciales)
+    salida->prepararCanal("Video con Ruido", WINDOW_AUTOSIZE);
+    salida->prepararCanal("Video Filtrado", WINDOW_AUTOSIZE);
+    salida->prepararCanal("Deteccion de Bordes Canny", WINDOW_AUTOSIZE);
+    salida->prepararCanal("Deteccion de Bordes Sobel", WINDOW_AUTOSIZE);
+    if (salida->interactiva()) {
+        createTrackbar("Sal", "Video con Ruido", &deslizador_sal, 100, on_trackbar);
+        createTrackbar("Pimienta", "Video con Ruido", &deslizador_pimienta, 100, on_trackbar);
+        createTrackbar("Tamano de la Mascara", "Video con Ruido", &deslizador_tamano_mascara, 10, on_trackbar);
+    } else {
+        instalarSenalesDetencion();
+    }
 
-        bordes_blur_sobel.copyTo(resultado_bordes_sobel(Rect(imagen_con_ruido.cols, 0, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_sobel, "Bordes Blur", Point(imagen_con_ruido.cols + 10, 30));
+    // El video se decodifica y redimensiona una vez; las vueltas siguientes salen del anillo
+    FuenteVideoCacheada fuente(cap, tamano_nuevo, limite_cache_mb * 1024 * 1024);
+    long frames = 0, reservas_previas = 0, buffers_pool_previos = 0;
+    bool pausado = false; // La barra espaciadora pausa y reanuda el video
+    while (true) {
+        if (!pausado) {
+            bool primera_vuelta = !fuente.completa();
+            if (!fuente.leer(imagen_original)) break; // Salir si no se puede capturar un fotograma
+            if (primera_vuelta && fuente.completa()) {
+                cout << "Video en memoria: " << fuente.frames() << " fotogramas, " << fuente.bytesAnillo() / (1024 * 1024)
+                     << " MB" << endl;
+            }
+            numero_fotograma++; // El ruido cambia en cada fotograma pero es reproducible para una semilla
+        }
 
-        bordes_gaussiano_sobel.copyTo(resultado_bordes_sobel(Rect(0, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_sobel, "Bordes Gaussiano", Point(10, imagen_con_ruido.rows + 30));
+        procesar(); // Ruido, filtros, bordes y ventanas, solo lo que cambió
 
-        deteccionBordesSobel(imagen_con_ruido, imagen_con_ruido); // Detectar bordes en la imagen con ruido
-        imagen_con_ruido.copyTo(resultado_bordes_sobel(Rect(imagen_con_ruido.cols, imagen_con_ruido.rows, imagen_con_ruido.cols, imagen_con_ruido.rows)));
-        agregarTexto(resultado_bordes_sobel, "Bordes Original", Point(imagen_con_ruido.cols + 10, imagen_con_ruido.rows + 30));
+        // Asignaciones reales de cv::Mat por frame, y cuántas de ellas son buffers nuevos del pool
+        if (++frames % 100 == 0) {
+            cout << "Asignaciones de Mat por frame: " << (asignador.reservas() - reservas_previas) / 100.0
+                 << " (buffers nuevos del pool: " << (pool.buffersCreados() - buffers_pool_previos) / 100.0 << ")" << endl;
+            reservas_previas = asignador.reservas();
+            buffers_pool_previos = pool.buffersCreados();
+        }
 
-        // Mostrar las imágenes de resultado
-        imshow("Video Filtrado", resultado_filtrado);
-        imshow("Deteccion de Bordes Canny", resultado_bordes_canny);
+        if (limite_fotogramas > 0 && frames >= limite_fotogramas) break;
 
-        imshow("Deteccion de Bordes Sobel", resultado_bordes_sobel);
+        if (salida->interactiva()) {
+            // Salir si se presiona la tecla ESC (waitKey necesita al menos 1 ms para atender la ventana)
+            int tecla = waitKey(max(1, espera));
+            if (tecla == 27) break;
+            if (tecla == ' ') pausado = !pausado;
+        } else {
+            if (detencionSolicitada()) break;
+            if (espera > 0) this_thread::sleep_for(chrono::milliseconds(espera));
+        }
+    }
 
-        // Salir si se presiona la tecla ESC
-        if (waitKey(23) == 27) break;
+    if (salida->descartados() > 0) {
+        cout << "Fotogramas descartados por la salida: " << salida->descartados() << endl;
     }
+    salida.reset(); // Termina de escribir los archivos pendientes
 
     return 0;
 }
@@ -0,0 +1,65 @@
+#ifndef RUIDO_HPP
+#define RUIDO_HPP
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+
+// Generador basado en contador: mezcla un entero de 32 bits (finalizador tipo
+// murmur). El valor de cada píxel depende solo de la semilla de su bloque y de
+// su posición, así que el resultado es idéntico con cualquier número de hilos.
+inline uint32_t mezclar32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Filas por bloque: cada bloque tiene su propia semilla y es la unidad de reparto entre hilos
+const int filasPorBloqueRuido = 16;
+
+// Función para agregar ruido de sal y pimienta a una imagen (8 bits, cualquier número de canales).
+// Los aleatorios se generan por tandas y se aplican con máscaras, sin saltos por píxel.
+inline void agregarRuidoSalPimienta(cv::Mat &imagen, float prob_sal, float prob_pimienta, uint32_t semilla) {
+    CV_Assert(imagen.depth() == CV_8U);
+    // Umbrales en el rango de 32 bits: aleatorio < umbral_sal es sal, < umbral_total es pimienta
+    auto umbral = [](double probabilidad) {
+        return uint32_t(std::min(std::max(probabilidad, 0.0) * 4294967296.0, 4294967295.0));
+    };
+    const uint32_t umbral_sal = umbral(prob_sal);
+    const uint32_t umbral_total = umbral(double(prob_sal) + prob_pimienta);
+    if (umbral_total == 0) return;
+
+    const int canales = imagen.channels();
+    const int bloques = (imagen.rows + filasPorBloqueRuido - 1) / filasPorBloqueRuido;
+    cv::parallel_for_(cv::Range(0, bloques), [&](const cv::Range &rango) {
+        const int tanda = 256;
+        uint32_t aleatorios[tanda];
+        for (int bloque = rango.start; bloque < rango.end; bloque++) {
+            const uint32_t semilla_bloque = mezclar32(semilla ^ mezclar32(uint32_t(bloque) + 0x9e3779b9u));
+            const int fila_fin = std::min(imagen.rows, (bloque + 1) * filasPorBloqueRuido);
+            for (int i = bloque * filasPorBloqueRuido; i < fila_fin; i++) {
+                uchar *fila = imagen.ptr<uchar>(i);
+                const uint32_t contador_fila = uint32_t(i - bloque * filasPorBloqueRuido) * uint32_t(imagen.cols);
+                for (int j0 = 0; j0 < imagen.cols; j0 += tanda) {
+                    const int n = std::min(tanda, imagen.cols - j0);
+                    for (int k = 0; k < n; k++) {
+                        aleatorios[k] = mezclar32(semilla_bloque + contador_fila + uint32_t(j0 + k));
+                    }
+                    uchar *p = fila + j0 * canales;
+                    for (int k = 0; k < n; k++) {
+                        const uchar sal = uchar(-(aleatorios[k] < umbral_sal));
+                        const uchar ruido = uchar(-(aleatorios[k] < umbral_total));
+                        for (int c = 0; c < canales; c++) {
+                            p[k * canales + c] = uchar((p[k * canales + c] & ~ruido) | sal);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SUAVIZADO_HPP
+#define SUAVIZADO_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+// Función que aplica los tres filtros de suavizado como tres pasadas completas. Un banco
+// por franjas con halo no resultó más rápido en los frames de 400x240 y se descartó.
+inline void aplicarFiltrosSuavizado(const cv::Mat &imagen, int tamano_mascara, cv::Mat &filtrado_mediana,
+                                    cv::Mat &filtrado_blur, cv::Mat &filtrado_gaussiano) {
+    cv::medianBlur(imagen, filtrado_mediana, tamano_mascara);
+    cv::blur(imagen, filtrado_blur, cv::Size(tamano_mascara, tamano_mascara));
+    cv::GaussianBlur(imagen, filtrado_gaussiano, cv::Size(tamano_mascara, tamano_mascara), 1.5);
+}
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef FRANJAS_HPP
+#define FRANJAS_HPP
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "morfologia.hpp"
+
+// Lector de PGM binario (P5, 8 bits) fila a fila: la imagen nunca se carga entera.
+// PGM es el formato de intercambio sin compresión que se puede leer por franjas;
+// los escaneos en otros formatos se convierten antes (por ejemplo con vips o convert).
+class LectorPGM {
+public:
+    explicit LectorPGM(const std::string& ruta) : ruta_(ruta), archivo_(ruta, std::ios::binary) {
+        if (!archivo_) throw std::runtime_error("No se pudo abrir " + ruta);
+        if (leerCampo() != "P5") throw std::runtime_error("Solo se admite PGM binario (P5) en " + ruta);
+        int ancho = std::stoi(leerCampo());
+        int alto = std::stoi(leerCampo());
+        int maximo = std::stoi(leerCampo());
+        if (ancho <= 0 || alto <= 0 || maximo != 255) throw std::runtime_error("Cabecera PGM no válida en " + ruta);
+        archivo_.get(); // Un único espacio separa la cabecera de los píxeles
+        tamano_ = cv::Size(ancho, alto);
+    }
+
+    // Lee las siguientes filas de la imagen en `destino` (su número de filas indica cuántas)
+    void leer(cv::Mat destino) {
+        for (int y = 0; y < destino.rows; y++) {
+            if (!archivo_.read(reinterpret_cast<char*>(destino.ptr<uchar>(y)), tamano_.width)) {
+                throw std::runtime_error("PGM truncado en " + ruta_);
+            }
+        }
+    }
+
+    cv::Size tamano() const { return tamano_; }
+
+private:
+    // Siguiente campo de la cabecera, saltando espacios y comentarios
+    std::string leerCampo() {
+        std::string campo;
+        while (archivo_ >> campo && campo[0] == '#') {
+            std::string resto;
+            std::getline(archivo_, resto);
+        }
+        return campo;
+    }
+
+    std::string ruta_;
+    std::ifstream archivo_;
+    cv::Size tamano_;
+};
+
+// Escritor de PGM binario que recibe la imagen por franjas y las agrega al archivo
+class EscritorPGM {
+public:
+    EscritorPGM(const std::string& ruta, cv::Size tamano) : ruta_(ruta), archivo_(ruta, std::ios::binary) {
+        if (!archivo_) throw std::runtime_error("No se pudo crear " + ruta);
+        archivo_ << "P5\n" << tamano.width << " " << tamano.height << "\n255\n";
+    }
+
+    void escribir(const cv::Mat& filas) {
+        for (int y = 0; y < filas.rows; y++) {
+            archivo_.write(reinterpret_cast<const char*>(filas.ptr<uchar>(y)), filas.cols);
+        }
+        if (!archivo_) throw std::runtime_error("Error al escribir " + ruta_);
+    }
+
+private:
+    std::string ruta_;
+    std::ofstream archivo_;
+};
+
+// Nombres de las cinco salidas del motor morfológico, en el orden de MotorMorfologico::procesar
+const char* const nombresSalidasMorfologicas[5] = {"erosion", "dilatacion", "tophat", "blackhat", "resultado"};
+
+// Aplica la cadena morfológica a un PGM por franjas horizontales de `filasFranja` filas y
+// escribe las cinco salidas como PGM a medida que avanza. La apertura y el cierre encadenan
+// dos operaciones de radio tamanoKernel/2, así que cada franja se procesa con un halo de
+// 2 * (tamanoKernel/2) filas por arriba y por abajo: con él las filas interiores salen
+// idénticas a las de procesar la imagen completa. Solo el halo se conserva entre franjas;
+// la memoria queda acotada por (filasFranja + 4 * radio) filas, no por el alto de la imagen.
+inline void procesarPorFranjas(const std::string& entrada, int tamanoKernel, int filasFranja,
+                               const std::vector<std::string>& salidas) {
+    LectorPGM lector(entrada);
+    const cv::Size tamano = lector.tamano();
+    const int halo = 2 * (tamanoKernel / 2);
+    std::vector<EscritorPGM> escritores;
+    escritores.reserve(salidas.size());
+    for (const std::string& ruta : salidas) escritores.emplace_back(ruta, tamano);
+
+    MotorMorfologico motor(tamanoKernel);
+    cv::Mat buffer(filasFranja + 2 * halo, tamano.width, CV_8UC1);
+    cv::Mat resultados[5];
+    int primera = 0, cargadas = 0; // Fila de la imagen en buffer.row(0) y filas válidas del buffer
+
+    for (int inicio = 0; inicio < tamano.height; inicio += filasFranja) {
+        const int fin = std::min(tamano.height, inicio + filasFranja);
+
+        // Descartar las filas que ya no forman parte del halo y subir el resto al inicio
+        const int descartar = std::max(0, inicio - halo) - primera;
+        if (descartar > 0) {
+            for (int y = 0; y + descartar < cargadas; y++) {
+                std::memcpy(buffer.ptr<uchar>(y), buffer.ptr<uchar>(y + descartar), tamano.width);
+            }
+            cargadas -= descartar;
+            primera += descartar;
+        }
+
+        // Leer hasta cubrir la franja y su halo inferior
+        const int necesarias = std::min(tamano.height, fin + halo) - primera;
+        lector.leer(buffer.rowRange(cargadas, necesarias));
+        cargadas = necesarias;
+
+        motor.procesar(buffer.rowRange(0, cargadas), resultados[0], resultados[1], resultados[2], resultados[3],
+                       resultados[4]);
+        for (size_t i = 0; i < escritores.size(); i++) {
+            escritores[i].escribir(resultados[i].rowRange(inicio - primera, fin - primera));
+        }
+    }
+}
+
+#endif
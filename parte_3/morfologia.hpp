@@ -0,0 +1,166 @@
+#ifndef MORFOLOGIA_HPP
+#define MORFOLOGIA_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+#include "pixel.hpp"
+
+// Operadores de la morfología en escala de grises: el valor neutro es el que se usa
+// fuera de la imagen (igual que el borde por defecto de erode/dilate de OpenCV)
+struct OperadorMinimo {
+    static constexpr uchar neutro = 255;
+    uchar operator()(uchar a, uchar b) const { return std::min(a, b); }
+};
+
+struct OperadorMaximo {
+    static constexpr uchar neutro = 0;
+    uchar operator()(uchar a, uchar b) const { return std::max(a, b); }
+};
+
+// Mínimo/máximo de van Herk/Gil-Werman sobre una ventana de `tamano` elementos
+// centrada en cada posición. La secuencia (con tamano/2 neutros a cada lado) se
+// parte en bloques de `tamano`: g acumula desde el inicio de cada bloque y h desde
+// su final, y cada ventana abarca a lo sumo dos bloques, así que su resultado es
+// op(h[x], g[x + tamano - 1]). Cuesta tres comparaciones por elemento para cualquier tamaño.
+template<typename Op>
+inline void minMaxFila(const uchar* fuente, uchar* destino, int n, int tamano, uchar* g, uchar* h) {
+    Op op;
+    const int radio = tamano / 2;
+    const int total = n + 2 * radio;
+    const int largo = (total + tamano - 1) / tamano * tamano;
+    auto valor = [&](int i) { return i >= radio && i < radio + n ? fuente[i - radio] : Op::neutro; };
+
+    for (int i = 0; i < largo; i++) g[i] = i % tamano == 0 ? valor(i) : op(g[i - 1], valor(i));
+    for (int i = largo - 1; i >= 0; i--) h[i] = i % tamano == tamano - 1 ? valor(i) : op(h[i + 1], valor(i));
+    for (int x = 0; x < n; x++) destino[x] = op(h[x], g[x + tamano - 1]);
+}
+
+// Pasada horizontal: cada fila por separado, repartidas entre los hilos
+template<typename Op>
+inline void pasadaHorizontal(const cv::Mat& imagen, cv::Mat& salida, int tamano) {
+    const int largo = (imagen.cols + 2 * (tamano / 2) + tamano - 1) / tamano * tamano;
+    cv::parallel_for_(cv::Range(0, imagen.rows), [&](const cv::Range& rango) {
+        std::vector<uchar> g(largo), h(largo);
+        for (int y = rango.start; y < rango.end; y++) {
+            minMaxFila<Op>(imagen.ptr<uchar>(y), salida.ptr<uchar>(y), imagen.cols, tamano, g.data(), h.data());
+        }
+    });
+}
+
+// Pasada vertical: el mismo algoritmo, pero avanzando fila a fila sobre franjas de
+// columnas, de modo que cada paso es una operación elemento a elemento sobre memoria
+// contigua que el compilador vectoriza
+template<typename Op>
+inline void pasadaVertical(const cv::Mat& imagen, cv::Mat& salida, int tamano) {
+    const int columnasPorFranja = 256;
+    const int n = imagen.rows, radio = tamano / 2;
+    const int largo = (n + 2 * radio + tamano - 1) / tamano * tamano;
+    const int franjas = (imagen.cols + columnasPorFranja - 1) / columnasPorFranja;
+
+    cv::parallel_for_(cv::Range(0, franjas), [&](const cv::Range& rango) {
+        Op op;
+        std::vector<uchar> g(size_t(largo) * columnasPorFranja), h(size_t(largo) * columnasPorFranja);
+        std::vector<uchar> neutros(columnasPorFranja, Op::neutro);
+        for (int franja = rango.start; franja < rango.end; franja++) {
+            const int x0 = franja * columnasPorFranja;
+            const int ancho = std::min(columnasPorFranja, imagen.cols - x0);
+            auto fila = [&](int i) { return i >= radio && i < radio + n ? imagen.ptr<uchar>(i - radio) + x0 : neutros.data(); };
+
+            for (int i = 0; i < largo; i++) {
+                const uchar* p = fila(i);
+                uchar* gi = &g[size_t(i) * columnasPorFranja];
+                if (i % tamano == 0) {
+                    std::copy(p, p + ancho, gi);
+                } else {
+                    const uchar* anterior = gi - columnasPorFranja;
+                    for (int x = 0; x < ancho; x++) gi[x] = op(anterior[x], p[x]);
+                }
+            }
+            for (int i = largo - 1; i >= 0; i--) {
+                const uchar* p = fila(i);
+                uchar* hi = &h[size_t(i) * columnasPorFranja];
+                if (i % tamano == tamano - 1) {
+                    std::copy(p, p + ancho, hi);
+                } else {
+                    const uchar* siguiente = hi + columnasPorFranja;
+                    for (int x = 0; x < ancho; x++) hi[x] = op(siguiente[x], p[x]);
+                }
+            }
+            for (int y = 0; y < n; y++) {
+                const uchar* hy = &h[size_t(y) * columnasPorFranja];
+                const uchar* gy = &g[size_t(y + tamano - 1) * columnasPorFranja];
+                uchar* d = salida.ptr<uchar>(y) + x0;
+                for (int x = 0; x < ancho; x++) d[x] = op(hy[x], gy[x]);
+            }
+        }
+    });
+}
+
+// Erosión (OperadorMinimo) o dilatación (OperadorMaximo) con un kernel rectangular
+// tamano x tamano: separable en una pasada horizontal y una vertical. Coincide con
+// erode/dilate de OpenCV con MORPH_RECT y el borde por defecto.
+template<typename Op>
+inline void minMaxRectangular(const cv::Mat& imagen, int tamano, cv::Mat& horizontal, cv::Mat& salida) {
+    CV_Assert(imagen.type() == CV_8UC1 && tamano % 2 == 1);
+    horizontal.create(imagen.size(), CV_8UC1);
+    pasadaHorizontal<Op>(imagen, horizontal, tamano);
+    salida.create(imagen.size(), CV_8UC1);
+    pasadaVertical<Op>(horizontal, salida, tamano);
+}
+
+// Función que aplica las operaciones con las llamadas de OpenCV por separado (camino de referencia)
+inline void operacionesMorfologicasOpenCV(const cv::Mat& imagen, int tamano, cv::Mat& erosionada, cv::Mat& dilatada,
+                                          cv::Mat& topHat, cv::Mat& blackHat, cv::Mat& resultado) {
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(tamano, tamano));
+    cv::erode(imagen, erosionada, kernel);
+    cv::dilate(imagen, dilatada, kernel);
+    cv::morphologyEx(imagen, topHat, cv::MORPH_TOPHAT, kernel);
+    cv::morphologyEx(imagen, blackHat, cv::MORPH_BLACKHAT, kernel);
+    cv::add(imagen, topHat - blackHat, resultado);
+}
+
+// Top hat, black hat y realce imagen + (topHat - blackHat) a partir de la apertura y el
+// cierre, como tres expresiones por píxel que se evalúan en un mismo recorrido
+inline auto asignacionesRealceMorfologico(const cv::Mat& imagen, const cv::Mat& apertura, const cv::Mat& cierre,
+                                          cv::Mat& topHat, cv::Mat& blackHat, cv::Mat& resultado) {
+    auto p = pixel::leer<uchar>(imagen);
+    auto diferenciaApertura = p - pixel::leer<uchar>(apertura);
+    auto diferenciaCierre = pixel::leer<uchar>(cierre) - p;
+    return std::make_tuple(pixel::asignar(topHat, diferenciaApertura), pixel::asignar(blackHat, diferenciaCierre),
+                           pixel::asignar(resultado, p + pixel::maximo(diferenciaApertura - diferenciaCierre, 0)));
+}
+
+// Motor morfológico para un tamaño de kernel: erosiona y dilata una sola vez y de ahí
+// deriva apertura (dilatar la erosión), cierre (erosionar la dilatación), top hat,
+// black hat y el realce imagen + (topHat - blackHat). Son cuatro pasadas separables
+// de costo constante por píxel, frente a las seis de costo proporcional al kernel
+// que hacen erode, dilate y los dos morphologyEx por separado.
+class MotorMorfologico {
+public:
+    explicit MotorMorfologico(int tamanoKernel) : tamano_(tamanoKernel) {}
+
+    // Las salidas pueden ser vistas de un mosaico: se escriben sin reasignar si ya tienen el tamaño
+    void procesar(const cv::Mat& imagen, cv::Mat& erosionada, cv::Mat& dilatada, cv::Mat& topHat, cv::Mat& blackHat,
+                  cv::Mat& resultado) {
+        minMaxRectangular<OperadorMinimo>(imagen, tamano_, intermedia_, erosionada);
+        minMaxRectangular<OperadorMaximo>(imagen, tamano_, intermedia_, dilatada);
+        minMaxRectangular<OperadorMaximo>(erosionada, tamano_, intermedia_, apertura_);
+        minMaxRectangular<OperadorMinimo>(dilatada, tamano_, intermedia_, cierre_);
+
+        // Top hat, black hat y resultado en un solo recorrido. La apertura nunca supera a
+        // la imagen ni el cierre queda por debajo, así que las restas no saturan; la
+        // resta y la suma finales saturan igual que los operadores de cv::Mat.
+        pixel::evaluar(asignacionesRealceMorfologico(imagen, apertura_, cierre_, topHat, blackHat, resultado));
+    }
+
+    int tamano() const { return tamano_; }
+
+private:
+    int tamano_;
+    cv::Mat intermedia_, apertura_, cierre_;
+};
+
+#endif
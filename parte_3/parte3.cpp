@@ -1,53 +1,304 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "pool_hilos.hpp"
+#include "mosaico.hpp"
+#include "morfologia.hpp"
+#include "franjas.hpp"
+#include "salida.hpp"
 
 using namespace cv;
 using namespace std;
 
-// Función para agregar texto a una imagen
-void agregarTexto(Mat &imagen, const string &texto, const Point &posicion) {
-    putText(imagen, texto, posicion, FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 255, 255), 2);
+// Función que compone el mosaico 3x2 de operaciones morfológicas de una imagen. Cada
+// operación escribe directamente en su panel, sin concatenaciones posteriores.
+void componerOperacionesMorfologicas(const Mat& imagen, int tamanoKernel, Mosaico& mosaico) {
+    mosaico.preparar(imagen.size());
+    mosaico.colocar(0, imagen);
+    Mat erosionada = mosaico.panel(1), dilatada = mosaico.panel(2);
+    Mat topHat = mosaico.panel(3), blackHat = mosaico.panel(4), resultado = mosaico.panel(5);
+
+    // Erosión y dilatación una sola vez; apertura, cierre, Top Hat, Black Hat y
+    // Original + (Top Hat - Black Hat) se derivan de ellas
+    MotorMorfologico motor(tamanoKernel);
+    motor.procesar(imagen, erosionada, dilatada, topHat, blackHat, resultado);
+
+    // Las etiquetas se estampan al final, cuando ninguna operación vuelve a leer los paneles
+    mosaico.etiquetar(1, "Erosion", Point(10, 30));
+    mosaico.etiquetar(2, "Dilatacion", Point(10, 30));
+    mosaico.etiquetar(3, "Top Hat", Point(10, 30));
+    mosaico.etiquetar(4, "Black Hat", Point(10, 30));
+    mosaico.etiquetar(5, "Resultado", Point(10, 30));
 }
 
-// Función para aplicar operaciones morfológicas a una imagen
-void aplicarOperacionesMorfologicas(const Mat& imagen, int tamanoKernel, const string& nombreImagen, int indice) {
-    Mat erosionada, dilatada, topHat, blackHat, resultado;
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(tamanoKernel, tamanoKernel));
+// Función para aplicar operaciones morfológicas a una imagen y entregarlas a la salida
+// (una ventana por combinación, o un archivo por combinación sin pantalla)
+void aplicarOperacionesMorfologicas(const Mat& imagen, int tamanoKernel, const string& nombreImagen, int indice,
+                                    SalidaFrames& salida) {
+    Mosaico mosaico(3, 2, CV_8UC1);
+    componerOperacionesMorfologicas(imagen, tamanoKernel, mosaico);
 
-    // Erosión
-    erode(imagen, erosionada, kernel);
-    agregarTexto(erosionada, "Erosion", Point(10, 30));
+    // Mostrar resultados
+    string nombreVentana = nombreImagen + " - Tamaño de Kernel " + to_string(tamanoKernel) + " (" + to_string(indice) + ")";
+    salida.prepararCanal(nombreVentana, WINDOW_NORMAL);
+    salida.enviar(nombreVentana, mosaico.lienzo()); // El mosaico es local: nadie vuelve a escribir su lienzo
+}
 
-    // Dilatación
-    dilate(imagen, dilatada, kernel);
-    agregarTexto(dilatada, "Dilatacion", Point(10, 30));
+// Función que lista las imágenes de un lote: los archivos de imagen de un directorio
+// (en orden alfabético) o las rutas de un manifiesto de texto, una por línea (sin el
+// \r de los finales de línea de Windows ni espacios al final)
+vector<string> listarLote(const string& origen) {
+    vector<string> rutas;
+    if (filesystem::is_directory(origen)) {
+        const vector<string> extensiones = {".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".pgm"};
+        for (const auto& entrada : filesystem::directory_iterator(origen)) {
+            string extension = entrada.path().extension().string();
+            transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (entrada.is_regular_file() && find(extensiones.begin(), extensiones.end(), extension) != extensiones.end()) {
+                rutas.push_back(entrada.path().string());
+            }
+        }
+        sort(rutas.begin(), rutas.end());
+    } else {
+        ifstream manifiesto(origen);
+        string linea;
+        while (getline(manifiesto, linea)) {
+            linea.erase(linea.find_last_not_of(" \t\r") + 1);
+            if (!linea.empty() && linea[0] != '#') rutas.push_back(linea);
+        }
+    }
+    return rutas;
+}
 
-    // Top Hat
-    morphologyEx(imagen, topHat, MORPH_TOPHAT, kernel);
-    agregarTexto(topHat, "Top Hat", Point(10, 30));
+// Nombre base de las salidas de una imagen del lote: el nombre del archivo con su
+// extensión, para que a.jpg y a.png no escriban en los mismos archivos
+string nombreSalidaLote(const string& ruta) { return filesystem::path(ruta).filename().string(); }
 
-    // Black Hat
-    morphologyEx(imagen, blackHat, MORPH_BLACKHAT, kernel);
-    agregarTexto(blackHat, "Black Hat", Point(10, 30));
+// Función que procesa un lote sin ventanas: un hilo de E/S decodifica las imágenes y
+// encola un trabajo por cada (imagen, kernel) en el pool; la imagen decodificada se
+// comparte entre sus kernels. Cada trabajo escribe su mosaico en el directorio de salida.
+// Si dos entradas darían el mismo nombre de salida, el lote se rechaza antes de empezar.
+// Como máximo hay 2 imágenes por hilo decodificadas a la vez, para acotar la memoria.
+int ejecutarLote(const string& origen, const string& directorioSalida, const vector<int>& tamanosKernel, unsigned hilos) {
+    vector<string> rutas = listarLote(origen);
+    if (rutas.empty()) {
+        cerr << "No hay imágenes en " << origen << endl;
+        return -1;
+    }
+    map<string, string> rutaPorNombre;
+    for (const string& ruta : rutas) {
+        auto insercion = rutaPorNombre.emplace(nombreSalidaLote(ruta), ruta);
+        if (!insercion.second) {
+            cerr << "Las imágenes " << insercion.first->second << " y " << ruta << " escribirían las mismas salidas ("
+                 << insercion.first->first << ")" << endl;
+            return -1;
+        }
+    }
+    filesystem::create_directories(directorioSalida);
 
-    // Original + (Top Hat - Black Hat)
-    resultado = imagen + (topHat - blackHat);
-    agregarTexto(resultado, "Resultado", Point(10, 30));
+    // El paralelismo está entre trabajos: los bucles internos de OpenCV van en serie
+    setNumThreads(1);
+    PoolHilos pool(hilos);
+    const size_t maximoEnVuelo = 2 * pool.hilos();
+    mutex mutexVuelo;
+    condition_variable hayLugar;
+    size_t enVuelo = 0;
+    atomic<long> imagenesProcesadas{0}, fallidas{0};
 
-    // Concatenar imágenes en una sola ventana
-    Mat combinada;
-    hconcat(vector<Mat>{imagen, erosionada, dilatada}, combinada);
-    Mat combinada2;
-    hconcat(vector<Mat>{topHat, blackHat, resultado}, combinada2);
-    vconcat(vector<Mat>{combinada, combinada2}, combinada);
+    int64 inicio = getTickCount();
+    thread hiloES([&] {
+        for (const string& ruta : rutas) {
+            {
+                unique_lock<mutex> lock(mutexVuelo);
+                hayLugar.wait(lock, [&] { return enVuelo < maximoEnVuelo; });
+                enVuelo++;
+            }
+            auto imagen = make_shared<const Mat>(imread(ruta, IMREAD_GRAYSCALE));
+            if (imagen->empty()) {
+                cerr << "Error al cargar " << ruta << endl;
+                fallidas++;
+                lock_guard<mutex> lock(mutexVuelo);
+                enVuelo--;
+                continue;
+            }
 
-    // Mostrar resultados
-    string nombreVentana = nombreImagen + " - Tamaño de Kernel " + to_string(tamanoKernel) + " (" + to_string(indice) + ")";
-    namedWindow(nombreVentana, WINDOW_NORMAL);
-    imshow(nombreVentana, combinada);
+            // El último kernel de la imagen la cuenta como procesada y libera su lugar
+            auto pendientes = make_shared<atomic<int>>(int(tamanosKernel.size()));
+            auto liberar = [&, pendientes] {
+                if (--*pendientes > 0) return;
+                imagenesProcesadas++;
+                lock_guard<mutex> lock(mutexVuelo);
+                enVuelo--;
+                hayLugar.notify_one();
+            };
+
+            string nombre = nombreSalidaLote(ruta);
+            for (int tamano : tamanosKernel) {
+                // Las tareas del pool no deben lanzar: los errores se informan y se cuentan
+                pool.encolar([&, imagen, nombre, tamano, liberar] {
+                    string salida = (filesystem::path(directorioSalida) / (nombre + "_k" + to_string(tamano) + ".png")).string();
+                    try {
+                        Mosaico mosaico(3, 2, CV_8UC1);
+                        componerOperacionesMorfologicas(*imagen, tamano, mosaico);
+                        if (!imwrite(salida, mosaico.lienzo())) throw runtime_error("imwrite falló");
+                    } catch (const exception& error) {
+                        cerr << "Error al escribir " << salida << ": " << error.what() << endl;
+                        fallidas++;
+                    }
+                    liberar();
+                });
+            }
+        }
+    });
+    hiloES.join();
+    pool.esperar();
+    double segundos = (getTickCount() - inicio) / getTickFrequency();
+
+    long procesadas = imagenesProcesadas.load();
+    cout << procesadas << " imágenes x " << tamanosKernel.size() << " kernels en " << segundos << " s con "
+         << pool.hilos() << " hilos: " << procesadas / segundos << " imágenes/s, "
+         << procesadas * tamanosKernel.size() / segundos << " mosaicos/s" << endl;
+    return fallidas ? -1 : 0;
+}
+
+// Función que mide el motor morfológico contra las llamadas de OpenCV para cada
+// tamaño de kernel y verifica que las cinco salidas coincidan
+void medirMorfologia(const Mat& imagen, const vector<int>& tamanosKernel) {
+    const int repeticiones = 10;
+    Mat referencia[5], motor[5];
+    cout << "kernel\topencv_ms\tmotor_ms\taceleracion\tidenticos" << endl;
+    for (int tamano : tamanosKernel) {
+        int64 inicio = getTickCount();
+        for (int r = 0; r < repeticiones; r++)
+            operacionesMorfologicasOpenCV(imagen, tamano, referencia[0], referencia[1], referencia[2], referencia[3], referencia[4]);
+        double opencv = (getTickCount() - inicio) * 1000.0 / getTickFrequency() / repeticiones;
+
+        MotorMorfologico motorMorfologico(tamano);
+        inicio = getTickCount();
+        for (int r = 0; r < repeticiones; r++)
+            motorMorfologico.procesar(imagen, motor[0], motor[1], motor[2], motor[3], motor[4]);
+        double propio = (getTickCount() - inicio) * 1000.0 / getTickFrequency() / repeticiones;
+
+        bool identicos = true;
+        for (int i = 0; i < 5; i++) identicos = identicos && norm(referencia[i], motor[i], NORM_INF) == 0;
+        cout << tamano << "x" << tamano << "\t" << opencv << "\t" << propio << "\t" << opencv / propio << "\t"
+             << (identicos ? "si" : "NO") << endl;
+    }
+}
+
+// Función que procesa un PGM por franjas para cada tamaño de kernel, sin cargarlo entero.
+// Con `verificar` compara cada salida escrita con el procesamiento de la imagen completa
+// (solo tiene sentido con imágenes que sí caben en memoria).
+int procesarEnFranjas(const string& entrada, const string& prefijo, const vector<int>& tamanosKernel, int filasFranja,
+                      bool verificar) {
+    for (int tamano : tamanosKernel) {
+        vector<string> salidas;
+        for (const char* nombre : nombresSalidasMorfologicas)
+            salidas.push_back(prefijo + "_k" + to_string(tamano) + "_" + nombre + ".pgm");
+
+        int64 inicio = getTickCount();
+        try {
+            procesarPorFranjas(entrada, tamano, filasFranja, salidas);
+        } catch (const exception& error) {
+            cerr << error.what() << endl;
+            return -1;
+        }
+        cout << "Kernel " << tamano << ": " << (getTickCount() - inicio) * 1000.0 / getTickFrequency() << " ms" << endl;
+
+        if (verificar) {
+            Mat imagen = imread(entrada, IMREAD_GRAYSCALE), completas[5];
+            MotorMorfologico(tamano).procesar(imagen, completas[0], completas[1], completas[2], completas[3], completas[4]);
+            for (int i = 0; i < 5; i++) {
+                Mat escrita = imread(salidas[i], IMREAD_GRAYSCALE);
+                bool identica = !escrita.empty() && norm(escrita, completas[i], NORM_INF) == 0;
+                cout << "  " << salidas[i] << ": " << (identica ? "idéntica" : "DIFERENTE") << endl;
+                if (!identica) return -1;
+            }
+        }
+    }
+    return 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Uso: parte3 [--kernels=15,25,37] [--medir-morfologia]
+    //      parte3 [--salida=ventana|video:DIR|mjpeg:DIR|png:DIR]
+    //      parte3 --franjas=entrada.pgm [--prefijo=prefijo] [--filas-franja=N] [--verificar]
+    //      parte3 --lote=directorio|manifiesto.txt [--directorio=directorio] [--hilos=N]
+    // --salida solo aplica al modo interactivo y elige el destino: ventana (por defecto),
+    // video:DIR, mjpeg:DIR o png:DIR para guardar los mosaicos sin pantalla. Los modos por
+    // franjas y por lotes escriben sus archivos con --prefijo y --directorio ("salida" por defecto).
+    bool medir = false, verificar = false;
+    string entradaFranjas, entradaLote, argumentoSalida, prefijoFranjas = "salida", directorioLote = "salida";
+    int filasFranja = 512;
+    unsigned hilos = thread::hardware_concurrency();
+    vector<int> tamanosKernel = {15, 25, 37};
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento == "--medir-morfologia") {
+            medir = true;
+        } else if (argumento.rfind("--franjas=", 0) == 0) {
+            entradaFranjas = argumento.substr(10);
+        } else if (argumento.rfind("--salida=", 0) == 0) {
+            argumentoSalida = argumento.substr(9);
+        } else if (argumento.rfind("--prefijo=", 0) == 0) {
+            prefijoFranjas = argumento.substr(10);
+        } else if (argumento.rfind("--directorio=", 0) == 0) {
+            directorioLote = argumento.substr(13);
+        } else if (argumento.rfind("--filas-franja=", 0) == 0) {
+            filasFranja = max(1, atoi(argumento.c_str() + 15));
+        } else if (argumento == "--verificar") {
+            verificar = true;
+        } else if (argumento.rfind("--lote=", 0) == 0) {
+            entradaLote = argumento.substr(7);
+        } else if (argumento.rfind("--hilos=", 0) == 0) {
+            hilos = unsigned(max(1, atoi(argumento.c_str() + 8)));
+        } else if (argumento.rfind("--kernels=", 0) == 0) {
+            tamanosKernel.clear();
+            stringstream lista(argumento.substr(10));
+            string tamano;
+            while (getline(lista, tamano, ',')) {
+                int valor = atoi(tamano.c_str());
+                if (valor <= 0 || valor % 2 == 0) {
+                    cerr << "Tamaño de kernel no válido: " << tamano << endl;
+                    return -1;
+                }
+                tamanosKernel.push_back(valor);
+            }
+            if (tamanosKernel.empty()) {
+                cerr << "La lista de kernels está vacía" << endl;
+                return -1;
+            }
+        } else {
+            cerr << "Argumento desconocido: " << argumento << endl;
+            return -1;
+        }
+    }
+
+    // Los modos por lotes y por franjas escriben archivos propios: --salida no aplica
+    if ((!entradaLote.empty() || !entradaFranjas.empty()) && !argumentoSalida.empty()) {
+        cerr << "--salida solo aplica al modo interactivo; use --directorio con --lote y --prefijo con --franjas" << endl;
+        return -1;
+    }
+
+    // Modo por lotes: sin ventanas, para servidores y conjuntos de imágenes
+    if (!entradaLote.empty()) {
+        return ejecutarLote(entradaLote, directorioLote, tamanosKernel, hilos);
+    }
+
+    // Modo por franjas: para imágenes que no caben en memoria, sin ventanas
+    if (!entradaFranjas.empty()) {
+        return procesarEnFranjas(entradaFranjas, prefijoFranjas, tamanosKernel, filasFranja, verificar);
+    }
+
     // Cargar imágenes médicas en escala de grises
     Mat imagen1 = imread("imagen1.jpg", IMREAD_GRAYSCALE);
     Mat imagen2 = imread("imagen2.jpg", IMREAD_GRAYSCALE);
@@ -58,18 +309,30 @@ int main() {
         return -1;
     }
 
-    // Aplicar operaciones morfológicas con diferentes tamaños de kernel
-    vector<int> tamanosKernel = {15, 25, 37};
+    if (medir) {
+        medirMorfologia(imagen1, tamanosKernel);
+        return 0;
+    }
+
+    // Cada mosaico se entrega una sola vez: la cola del escritor los guarda todos
+    unique_ptr<SalidaFrames> salida;
+    try {
+        salida = crearSalida(argumentoSalida, 1.0, 3 * tamanosKernel.size());
+    } catch (const exception& error) {
+        cerr << error.what() << endl;
+        return -1;
+    }
 
+    // Aplicar operaciones morfológicas con los distintos tamaños de kernel
     for (int tamano : tamanosKernel) {
         cout << "Tamaño del kernel: " << tamano << endl;
-        aplicarOperacionesMorfologicas(imagen1, tamano, "Imagen 1", tamano);
-        aplicarOperacionesMorfologicas(imagen2, tamano, "Imagen 2", tamano);
-        aplicarOperacionesMorfologicas(imagen3, tamano, "Imagen 3", tamano);
+        aplicarOperacionesMorfologicas(imagen1, tamano, "Imagen 1", tamano, *salida);
+        aplicarOperacionesMorfologicas(imagen2, tamano, "Imagen 2", tamano, *salida);
+        aplicarOperacionesMorfologicas(imagen3, tamano, "Imagen 3", tamano, *salida);
     }
 
-    // Esperar una tecla antes de salir
-    waitKey(0);
+    // Esperar una tecla antes de salir; sin ventanas, la salida termina de escribir al destruirse
+    if (salida->interactiva()) waitKey(0);
 
     return 0;
 }